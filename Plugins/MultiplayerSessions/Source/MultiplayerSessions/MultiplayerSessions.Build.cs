@@ -41,6 +41,11 @@ public class MultiplayerSessions : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"DeveloperSettings",
+				"Icmp",
+				"Sockets",
+				"OnlineSubsystemUtils",
+				"EngineSettings",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
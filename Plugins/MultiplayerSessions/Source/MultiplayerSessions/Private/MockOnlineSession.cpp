@@ -0,0 +1,574 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MockOnlineSession.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "OnlineSubsystemTypes.h"
+#include "MultiplayerSessionsLog.h"
+
+namespace
+{
+    const FName MockNetIdType(TEXT("Mock"));
+
+    /**
+     * @brief Session info of a mock session, only carries its id.
+     */
+    class FMockSessionInfo : public FOnlineSessionInfo
+    {
+    public:
+
+        explicit FMockSessionInfo(const FString& _SessionId) : SessionId(FUniqueNetIdString::Create(_SessionId, MockNetIdType)) {}
+
+        virtual const uint8* GetBytes() const override { return nullptr; }
+        virtual int32 GetSize() const override { return sizeof(FMockSessionInfo); }
+        virtual bool IsValid() const override { return true; }
+        virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+        virtual FString ToString() const override { return SessionId->ToString(); }
+        virtual FString ToDebugString() const override { return FString::Printf(TEXT("MockSession %s"), *SessionId->ToString()); }
+
+    private:
+
+        FUniqueNetIdRef SessionId;
+    };
+}
+
+float FMockLatency::Sample(FRandomStream& _Random) const
+{
+    switch(Distribution)
+    {
+    case EMockLatencyDistribution::Uniform:
+        return FMath::Max(0.f, _Random.FRandRange(Mean - Spread, Mean + Spread));
+
+    case EMockLatencyDistribution::LogNormal:
+    {
+        if(Mean <= 0.f)
+        {
+            return 0.f;
+        }
+        // Box-Muller, then shift the underlying normal so the distribution keeps Mean as its mean
+        const float U1 = FMath::Max(_Random.FRand(), UE_SMALL_NUMBER);
+        const float U2 = _Random.FRand();
+        const float Normal = FMath::Sqrt(-2.f * FMath::Loge(U1)) * FMath::Cos(2.f * UE_PI * U2);
+        const float Mu = FMath::Loge(Mean) - 0.5f * Spread * Spread;
+        return FMath::Exp(Mu + Spread * Normal);
+    }
+
+    case EMockLatencyDistribution::Fixed:
+    default:
+        return FMath::Max(0.f, Mean);
+    }
+}
+
+FMockOnlineSession::FMockOnlineSession(const FMockOnlineSessionConfig& _Config)
+    : Config(_Config)
+    , Random(_Config.Seed)
+{
+    BuildSearchResults();
+}
+
+FMockOnlineSession::~FMockOnlineSession()
+{
+    for(const TPair<uint32, FTSTicker::FDelegateHandle>& Pair : PendingCompletions)
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(Pair.Value);
+    }
+}
+
+void FMockOnlineSession::BuildSearchResults()
+{
+    SearchResults.Reset(Config.NumSearchResults);
+    for(int32 Index = 0; Index < Config.NumSearchResults; ++Index)
+    {
+        FOnlineSessionSearchResult& Result = SearchResults.AddDefaulted_GetRef();
+        Result.PingInMs = Random.RandRange(5, FMath::Max(Config.MaxPingInMs, 5));
+
+        FOnlineSession& Session = Result.Session;
+        Session.OwningUserId = FUniqueNetIdString::Create(FString::Printf(TEXT("MockHost%d"), Index), MockNetIdType);
+        Session.OwningUserName = FString::Printf(TEXT("MockHost%d"), Index);
+        Session.SessionInfo = MakeShared<FMockSessionInfo>(FString::Printf(TEXT("MockSession%d"), Index));
+        Session.SessionSettings.NumPublicConnections = FMath::Max(Config.MaxPublicConnections, 1);
+        Session.SessionSettings.bShouldAdvertise = true;
+        Session.SessionSettings.bUsesPresence = true;
+        Session.SessionSettings.BuildUniqueId = 1;
+        Session.NumOpenPublicConnections = Random.RandRange(0, Session.SessionSettings.NumPublicConnections);
+
+        if(Config.MatchTypes.Num() > 0)
+        {
+            const FString& MatchType = Config.MatchTypes[Random.RandRange(0, Config.MatchTypes.Num() - 1)];
+            Session.SessionSettings.Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+        }
+    }
+}
+
+uint32 FMockOnlineSession::ScheduleCompletion(EMockSessionOperation _Operation, TFunction<bool()>&& _Completion)
+{
+    const uint32 CompletionId = NextCompletionId++;
+    const float Delay = Config.Latency.Sample(Random);
+
+    TWeakPtr<FMockOnlineSession, ESPMode::ThreadSafe> WeakThis = AsShared();
+    const FTSTicker::FDelegateHandle Handle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+        [WeakThis, CompletionId, _Operation, Completion = MoveTemp(_Completion)](float DeltaTime)
+        {
+            TSharedPtr<FMockOnlineSession, ESPMode::ThreadSafe> This = WeakThis.Pin();
+            if(This.IsValid())
+            {
+                This->PendingCompletions.Remove(CompletionId);
+
+                const uint64 StartCycles = FPlatformTime::Cycles64();
+                const bool bSuccess = Completion();
+                This->CallbackSeconds += FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+                if(This->OnOperationHandled)
+                {
+                    This->OnOperationHandled(_Operation, bSuccess);
+                }
+            }
+            return false;
+        }), Delay);
+
+    PendingCompletions.Add(CompletionId, Handle);
+    return CompletionId;
+}
+
+void FMockOnlineSession::CancelCompletion(uint32 _CompletionId)
+{
+    FTSTicker::FDelegateHandle Handle;
+    if(PendingCompletions.RemoveAndCopyValue(_CompletionId, Handle))
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(Handle);
+    }
+}
+
+bool FMockOnlineSession::RollFailure()
+{
+    return Config.FailureRate > 0.f && Random.FRand() < Config.FailureRate;
+}
+
+FUniqueNetIdPtr FMockOnlineSession::CreateSessionIdFromString(const FString& SessionIdStr)
+{
+    return FUniqueNetIdString::Create(SessionIdStr, MockNetIdType);
+}
+
+FNamedOnlineSession* FMockOnlineSession::GetNamedSession(FName SessionName)
+{
+    return Sessions.FindByPredicate([SessionName](const FNamedOnlineSession& Session) { return Session.SessionName == SessionName; });
+}
+
+void FMockOnlineSession::RemoveNamedSession(FName SessionName)
+{
+    Sessions.RemoveAll([SessionName](const FNamedOnlineSession& Session) { return Session.SessionName == SessionName; });
+}
+
+bool FMockOnlineSession::HasPresenceSession()
+{
+    return Sessions.ContainsByPredicate([](const FNamedOnlineSession& Session) { return Session.SessionSettings.bUsesPresence; });
+}
+
+EOnlineSessionState::Type FMockOnlineSession::GetSessionState(FName SessionName) const
+{
+    const FNamedOnlineSession* Session = Sessions.FindByPredicate([SessionName](const FNamedOnlineSession& Named) { return Named.SessionName == SessionName; });
+    return Session ? Session->SessionState : EOnlineSessionState::NoSession;
+}
+
+FNamedOnlineSession* FMockOnlineSession::AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings)
+{
+    return &Sessions.Emplace_GetRef(SessionName, SessionSettings);
+}
+
+FNamedOnlineSession* FMockOnlineSession::AddNamedSession(FName SessionName, const FOnlineSession& Session)
+{
+    return &Sessions.Emplace_GetRef(SessionName, Session);
+}
+
+bool FMockOnlineSession::CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+    if(GetNamedSession(SessionName))
+    {
+        return false;
+    }
+
+    FNamedOnlineSession* Session = AddNamedSession(SessionName, NewSessionSettings);
+    Session->SessionState = EOnlineSessionState::Creating;
+    Session->bHosting = true;
+    Session->NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
+    Session->SessionInfo = MakeShared<FMockSessionInfo>(FString::Printf(TEXT("MockHosted%u"), NextCompletionId));
+
+    const bool bFails = RollFailure();
+    ScheduleCompletion(EMockSessionOperation::Create, [this, SessionName, bFails]()
+    {
+        if(bFails)
+        {
+            RemoveNamedSession(SessionName);
+        }
+        else if(FNamedOnlineSession* Created = GetNamedSession(SessionName))
+        {
+            Created->SessionState = EOnlineSessionState::Pending;
+        }
+        TriggerOnCreateSessionCompleteDelegates(SessionName, !bFails);
+        return !bFails;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+    return CreateSession(0, SessionName, NewSessionSettings);
+}
+
+bool FMockOnlineSession::StartSession(FName SessionName)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+
+    const bool bFails = RollFailure();
+    Session->SessionState = EOnlineSessionState::Starting;
+    ScheduleCompletion(EMockSessionOperation::Start, [this, SessionName, bFails]()
+    {
+        if(FNamedOnlineSession* Started = GetNamedSession(SessionName))
+        {
+            Started->SessionState = bFails ? EOnlineSessionState::Pending : EOnlineSessionState::InProgress;
+        }
+        TriggerOnStartSessionCompleteDelegates(SessionName, !bFails);
+        return !bFails;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+
+    const bool bFails = RollFailure();
+    if(!bFails)
+    {
+        Session->SessionSettings = UpdatedSessionSettings;
+    }
+    ScheduleCompletion(EMockSessionOperation::Update, [this, SessionName, bFails]()
+    {
+        TriggerOnUpdateSessionCompleteDelegates(SessionName, !bFails);
+        return !bFails;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::EndSession(FName SessionName)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+
+    Session->SessionState = EOnlineSessionState::Ending;
+    ScheduleCompletion(EMockSessionOperation::End, [this, SessionName]()
+    {
+        if(FNamedOnlineSession* Ended = GetNamedSession(SessionName))
+        {
+            Ended->SessionState = EOnlineSessionState::Ended;
+        }
+        TriggerOnEndSessionCompleteDelegates(SessionName, true);
+        return true;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::DestroySession(FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+
+    // Destroying never fails on the real backends either, the local session is always removed
+    Session->SessionState = EOnlineSessionState::Destroying;
+    ScheduleCompletion(EMockSessionOperation::Destroy, [this, SessionName, CompletionDelegate]()
+    {
+        RemoveNamedSession(SessionName);
+        CompletionDelegate.ExecuteIfBound(SessionName, true);
+        TriggerOnDestroySessionCompleteDelegates(SessionName, true);
+        return true;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::IsPlayerInSession(FName SessionName, const FUniqueNetId& UniqueId)
+{
+    const FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    return Session && Session->RegisteredPlayers.ContainsByPredicate([&UniqueId](const FUniqueNetIdRef& Player) { return *Player == UniqueId; });
+}
+
+bool FMockOnlineSession::StartMatchmaking(const TArray<FUniqueNetIdRef>& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    return false;
+}
+
+bool FMockOnlineSession::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
+{
+    return false;
+}
+
+bool FMockOnlineSession::CancelMatchmaking(const FUniqueNetId& SearchingPlayerId, FName SessionName)
+{
+    return false;
+}
+
+bool FMockOnlineSession::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    if(CurrentSearch.IsValid())
+    {
+        return false;
+    }
+
+    CurrentSearch = SearchSettings;
+    SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+    SearchSettings->SearchResults.Reset();
+
+    const bool bFails = RollFailure();
+    SearchCompletionId = ScheduleCompletion(EMockSessionOperation::Find, [this, bFails]()
+    {
+        TSharedPtr<FOnlineSessionSearch> Search = MoveTemp(CurrentSearch);
+        CurrentSearch.Reset();
+        SearchCompletionId = 0;
+
+        if(bFails)
+        {
+            Search->SearchState = EOnlineAsyncTaskState::Failed;
+        }
+        else
+        {
+            // A real backend deserializes its answer into the search, the copy is part of the cost
+            const int32 NumResults = FMath::Min(SearchResults.Num(), Search->MaxSearchResults);
+            Search->SearchResults.Append(SearchResults.GetData(), NumResults);
+            Search->SearchState = EOnlineAsyncTaskState::Done;
+        }
+        TriggerOnFindSessionsCompleteDelegates(!bFails);
+        return !bFails;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+    return FindSessions(0, SearchSettings);
+}
+
+bool FMockOnlineSession::FindSessionById(const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate)
+{
+    return false;
+}
+
+bool FMockOnlineSession::CancelFindSessions()
+{
+    if(!CurrentSearch.IsValid())
+    {
+        return false;
+    }
+
+    CancelCompletion(SearchCompletionId);
+    SearchCompletionId = 0;
+    CurrentSearch->SearchState = EOnlineAsyncTaskState::Failed;
+    CurrentSearch.Reset();
+
+    ScheduleCompletion(EMockSessionOperation::CancelFind, [this]()
+    {
+        TriggerOnCancelFindSessionsCompleteDelegates(true);
+        return true;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::PingSearchResults(const FOnlineSessionSearchResult& SearchResult)
+{
+    return false;
+}
+
+bool FMockOnlineSession::JoinSession(int32 LocalUserNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+    if(GetNamedSession(SessionName))
+    {
+        ScheduleCompletion(EMockSessionOperation::Join, [this, SessionName]()
+        {
+            TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::AlreadyInSession);
+            return false;
+        });
+        return true;
+    }
+
+    FNamedOnlineSession* Session = AddNamedSession(SessionName, DesiredSession.Session);
+    Session->SessionState = EOnlineSessionState::Pending;
+
+    // A full session is the usual reason for a join to fail
+    const bool bFails = DesiredSession.Session.NumOpenPublicConnections <= 0 || RollFailure();
+    ScheduleCompletion(EMockSessionOperation::Join, [this, SessionName, bFails]()
+    {
+        if(bFails)
+        {
+            RemoveNamedSession(SessionName);
+        }
+        TriggerOnJoinSessionCompleteDelegates(SessionName, bFails ? EOnJoinSessionCompleteResult::SessionIsFull : EOnJoinSessionCompleteResult::Success);
+        return !bFails;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::JoinSession(const FUniqueNetId& LocalUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+    return JoinSession(0, SessionName, DesiredSession);
+}
+
+bool FMockOnlineSession::FindFriendSession(int32 LocalUserNum, const FUniqueNetId& Friend)
+{
+    return false;
+}
+
+bool FMockOnlineSession::FindFriendSession(const FUniqueNetId& LocalUserId, const FUniqueNetId& Friend)
+{
+    return false;
+}
+
+bool FMockOnlineSession::FindFriendSession(const FUniqueNetId& LocalUserId, const TArray<FUniqueNetIdRef>& FriendList)
+{
+    return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend)
+{
+    return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriend(const FUniqueNetId& LocalUserId, FName SessionName, const FUniqueNetId& Friend)
+{
+    return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriends(int32 LocalUserNum, FName SessionName, const TArray<FUniqueNetIdRef>& Friends)
+{
+    return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriends(const FUniqueNetId& LocalUserId, FName SessionName, const TArray<FUniqueNetIdRef>& Friends)
+{
+    return false;
+}
+
+bool FMockOnlineSession::GetResolvedConnectString(FName SessionName, FString& ConnectInfo, FName PortType)
+{
+    const FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+    ConnectInfo = TEXT("127.0.0.1:7777");
+    return true;
+}
+
+bool FMockOnlineSession::GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo)
+{
+    if(!SearchResult.IsValid())
+    {
+        return false;
+    }
+    ConnectInfo = TEXT("127.0.0.1:7777");
+    return true;
+}
+
+FOnlineSessionSettings* FMockOnlineSession::GetSessionSettings(FName SessionName)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    return Session ? &Session->SessionSettings : nullptr;
+}
+
+bool FMockOnlineSession::RegisterPlayer(FName SessionName, const FUniqueNetId& PlayerId, bool bWasInvited)
+{
+    return RegisterPlayers(SessionName, {PlayerId.AsShared()}, bWasInvited);
+}
+
+bool FMockOnlineSession::RegisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players, bool bWasInvited)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+
+    for(const FUniqueNetIdRef& Player : Players)
+    {
+        if(!Session->RegisteredPlayers.ContainsByPredicate([&Player](const FUniqueNetIdRef& Registered) { return *Registered == *Player; }))
+        {
+            Session->RegisteredPlayers.Add(Player);
+            Session->NumOpenPublicConnections = FMath::Max(Session->NumOpenPublicConnections - 1, 0);
+        }
+    }
+
+    ScheduleCompletion(EMockSessionOperation::RegisterPlayers, [this, SessionName, Players]()
+    {
+        TriggerOnRegisterPlayersCompleteDelegates(SessionName, Players, true);
+        return true;
+    });
+    return true;
+}
+
+bool FMockOnlineSession::UnregisterPlayer(FName SessionName, const FUniqueNetId& PlayerId)
+{
+    return UnregisterPlayers(SessionName, {PlayerId.AsShared()});
+}
+
+bool FMockOnlineSession::UnregisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players)
+{
+    FNamedOnlineSession* Session = GetNamedSession(SessionName);
+    if(!Session)
+    {
+        return false;
+    }
+
+    for(const FUniqueNetIdRef& Player : Players)
+    {
+        if(Session->RegisteredPlayers.RemoveAll([&Player](const FUniqueNetIdRef& Registered) { return *Registered == *Player; }) > 0)
+        {
+            Session->NumOpenPublicConnections = FMath::Min(Session->NumOpenPublicConnections + 1, Session->SessionSettings.NumPublicConnections);
+        }
+    }
+
+    ScheduleCompletion(EMockSessionOperation::UnregisterPlayers, [this, SessionName, Players]()
+    {
+        TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, true);
+        return true;
+    });
+    return true;
+}
+
+void FMockOnlineSession::RegisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate)
+{
+    Delegate.ExecuteIfBound(PlayerId, EOnJoinSessionCompleteResult::Success);
+}
+
+void FMockOnlineSession::UnregisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate)
+{
+    Delegate.ExecuteIfBound(PlayerId, true);
+}
+
+int32 FMockOnlineSession::GetNumSessions()
+{
+    return Sessions.Num();
+}
+
+void FMockOnlineSession::DumpSessionState()
+{
+    for(const FNamedOnlineSession& Session : Sessions)
+    {
+        UE_LOG(LogMultiplayerSessions, Display, TEXT("Mock session %s: %s, %d/%d open"), *Session.SessionName.ToString(), EOnlineSessionState::ToString(Session.SessionState),
+            Session.NumOpenPublicConnections, Session.SessionSettings.NumPublicConnections);
+    }
+}
+
+#endif
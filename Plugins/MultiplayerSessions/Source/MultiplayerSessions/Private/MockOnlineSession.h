@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "Containers/Ticker.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "OnlineSessionSettings.h"
+
+/**
+ * @brief How long the mock backend takes to answer.
+ */
+enum class EMockLatencyDistribution : uint8
+{
+	Fixed,		// Always Mean
+	Uniform,	// Between Mean - Spread and Mean + Spread
+	LogNormal	// Mean, with a long tail. Spread is the sigma of the underlying normal distribution
+};
+
+struct FMockLatency
+{
+	EMockLatencyDistribution Distribution{EMockLatencyDistribution::Fixed};
+	float Mean{0.05f};
+	float Spread{0.f};
+
+	/**
+	 * @return A delay in seconds, never negative.
+	 */
+	float Sample(FRandomStream& _Random) const;
+};
+
+/**
+ * @brief Behaviour of the mock backend. Everything random comes from Seed, so two runs with the same configuration
+ * produce the same results, delays and failures.
+ */
+struct FMockOnlineSessionConfig
+{
+	int32 Seed{1234};
+
+	// Sessions returned by every search, from 0 to a few 100k
+	int32 NumSearchResults{100};
+
+	// Advertised MatchType of the sessions, picked at random
+	TArray<FString> MatchTypes{TEXT("FreeForAll")};
+
+	int32 MaxPublicConnections{8};
+	int32 MaxPingInMs{250};
+
+	FMockLatency Latency;
+
+	// Chance for an operation to fail, from 0 to 1. The failure is reported by the completion delegate, like a backend error.
+	float FailureRate{0.f};
+};
+
+enum class EMockSessionOperation : uint8
+{
+	Create,
+	Start,
+	Update,
+	End,
+	Destroy,
+	Find,
+	CancelFind,
+	Join,
+	RegisterPlayers,
+	UnregisterPlayers
+};
+
+/**
+ * @brief Session interface without any backend, to run the session flows headless (no Steam, no network).
+ * It keeps named sessions like the real interfaces and answers each call after a simulated delay, on the game thread.
+ * Custom QuerySettings are ignored, like the NULL subsystem does.
+ */
+class FMockOnlineSession : public IOnlineSession, public TSharedFromThis<FMockOnlineSession, ESPMode::ThreadSafe>
+{
+public:
+
+	explicit FMockOnlineSession(const FMockOnlineSessionConfig& _Config);
+	virtual ~FMockOnlineSession();
+
+	/**
+	 * @brief Time spent in the completion delegates, i.e. in the code under test, since the last reset.
+	 */
+	double GetCallbackSeconds() const { return CallbackSeconds; }
+	void ResetCallbackSeconds() { CallbackSeconds = 0.0; }
+
+	/**
+	 * @brief Called once the completion delegates of an operation returned, i.e. once the code under test handled the answer.
+	 */
+	TFunction<void(EMockSessionOperation, bool)> OnOperationHandled;
+
+	/**
+	 * @brief Every session a search returns, before the subsystem filters them.
+	 */
+	const TArray<FOnlineSessionSearchResult>& GetSearchResults() const { return SearchResults; }
+
+	// IOnlineSession
+	virtual FUniqueNetIdPtr CreateSessionIdFromString(const FString& SessionIdStr) override;
+	virtual FNamedOnlineSession* GetNamedSession(FName SessionName) override;
+	virtual void RemoveNamedSession(FName SessionName) override;
+	virtual bool HasPresenceSession() override;
+	virtual EOnlineSessionState::Type GetSessionState(FName SessionName) const override;
+	virtual bool CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool EndSession(FName SessionName) override;
+	virtual bool DestroySession(FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate = FOnDestroySessionCompleteDelegate()) override;
+	virtual bool IsPlayerInSession(FName SessionName, const FUniqueNetId& UniqueId) override;
+	virtual bool StartMatchmaking(const TArray<FUniqueNetIdRef>& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName) override;
+	virtual bool CancelMatchmaking(const FUniqueNetId& SearchingPlayerId, FName SessionName) override;
+	virtual bool FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool FindSessionById(const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool PingSearchResults(const FOnlineSessionSearchResult& SearchResult) override;
+	virtual bool JoinSession(int32 LocalUserNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool JoinSession(const FUniqueNetId& LocalUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool FindFriendSession(int32 LocalUserNum, const FUniqueNetId& Friend) override;
+	virtual bool FindFriendSession(const FUniqueNetId& LocalUserId, const FUniqueNetId& Friend) override;
+	virtual bool FindFriendSession(const FUniqueNetId& LocalUserId, const TArray<FUniqueNetIdRef>& FriendList) override;
+	virtual bool SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend) override;
+	virtual bool SendSessionInviteToFriend(const FUniqueNetId& LocalUserId, FName SessionName, const FUniqueNetId& Friend) override;
+	virtual bool SendSessionInviteToFriends(int32 LocalUserNum, FName SessionName, const TArray<FUniqueNetIdRef>& Friends) override;
+	virtual bool SendSessionInviteToFriends(const FUniqueNetId& LocalUserId, FName SessionName, const TArray<FUniqueNetIdRef>& Friends) override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo, FName PortType = NAME_GamePort) override;
+	virtual bool GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo) override;
+	virtual FOnlineSessionSettings* GetSessionSettings(FName SessionName) override;
+	virtual bool RegisterPlayer(FName SessionName, const FUniqueNetId& PlayerId, bool bWasInvited) override;
+	virtual bool RegisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players, bool bWasInvited = false) override;
+	virtual bool UnregisterPlayer(FName SessionName, const FUniqueNetId& PlayerId) override;
+	virtual bool UnregisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players) override;
+	virtual void RegisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate) override;
+	virtual void UnregisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate) override;
+	virtual int32 GetNumSessions() override;
+	virtual void DumpSessionState() override;
+
+protected:
+
+	virtual FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings) override;
+	virtual FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSession& Session) override;
+
+private:
+
+	/**
+	 * @brief Run _Completion after a delay drawn from the latency distribution, like an answer of the backend.
+	 * The time spent in _Completion is added to the callback time. _Completion returns whether the operation succeeded.
+	 * @return Id to cancel the completion with.
+	 */
+	uint32 ScheduleCompletion(EMockSessionOperation _Operation, TFunction<bool()>&& _Completion);
+	void CancelCompletion(uint32 _CompletionId);
+	bool RollFailure();
+
+	/**
+	 * @brief Sessions returned by the searches. Built once, so a search only costs the copy into the search results.
+	 */
+	void BuildSearchResults();
+
+	FMockOnlineSessionConfig Config;
+	FRandomStream Random;
+
+	TArray<FNamedOnlineSession> Sessions;
+	TArray<FOnlineSessionSearchResult> SearchResults;
+	TSharedPtr<FOnlineSessionSearch> CurrentSearch;
+	uint32 SearchCompletionId{0};
+	TMap<uint32, FTSTicker::FDelegateHandle> PendingCompletions;
+	uint32 NextCompletionId{1};
+
+	double CallbackSeconds{0.0};
+};
+
+#endif
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsLog.h"
+#include "Misc/OutputDevice.h"
+
+DEFINE_LOG_CATEGORY(LogMultiplayerSessions);
+
+namespace
+{
+    const TCHAR* LexEvent(ESessionEvent _Event)
+    {
+        switch(_Event)
+        {
+        case ESessionEvent::Requested:  return TEXT("Requested");
+        case ESessionEvent::Started:    return TEXT("Started");
+        case ESessionEvent::Completed:  return TEXT("Completed");
+        case ESessionEvent::Failed:     return TEXT("Failed");
+        case ESessionEvent::TimedOut:   return TEXT("TimedOut");
+        case ESessionEvent::Cancelled:  return TEXT("Cancelled");
+        case ESessionEvent::CacheHit:   return TEXT("CacheHit");
+        case ESessionEvent::Retried:    return TEXT("Retried");
+        case ESessionEvent::Hedged:     return TEXT("Hedged");
+        case ESessionEvent::ResultsFrom: return TEXT("ResultsFrom");
+        default:                        return TEXT("Unknown");
+        }
+    }
+}
+
+void FSessionEventLog::Record(ESessionEvent _Event, ESessionOperationType _Operation, int32 _Code)
+{
+    FSessionEventRecord& Record = Events[NextEvent];
+    Record.Time = FPlatformTime::Seconds();
+    Record.Event = _Event;
+    Record.Operation = _Operation;
+    Record.Code = _Code;
+
+    NextEvent = (NextEvent + 1) % Capacity;
+    NumEvents = FMath::Min(NumEvents + 1, Capacity);
+}
+
+void FSessionEventLog::Dump(FOutputDevice& _Ar, ELogVerbosity::Type _Verbosity) const
+{
+    const double Now = FPlatformTime::Seconds();
+    const int32 FirstEvent = NumEvents < Capacity ? 0 : NextEvent;
+    for(int32 Offset = 0; Offset < NumEvents; ++Offset)
+    {
+        const FSessionEventRecord& Record = Events[(FirstEvent + Offset) % Capacity];
+        _Ar.CategorizedLogf(LogMultiplayerSessions.GetCategoryName(), _Verbosity, TEXT("  %8.3f s ago  %-8s %-9s code %d"),
+            Now - Record.Time, LexToString(Record.Operation), LexEvent(Record.Event), Record.Code);
+    }
+}
+
+void FSessionEventLog::Empty()
+{
+    NextEvent = 0;
+    NumEvents = 0;
+}
@@ -0,0 +1,13 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionsSettings.h"
+
+UMultiplayerSessionsSettings::UMultiplayerSessionsSettings()
+{
+    // Show the settings under Project Settings > Plugins
+    CategoryName = TEXT("Plugins");
+    SectionName = TEXT("MultiplayerSessions");
+
+    IndexedSessionSettingKeys.Add(FName("MatchType"));
+}
@@ -4,6 +4,160 @@
 #include "MultiplayerSessionsSubsystem.h"
 #include "OnlineSubsystem.h"
 #include "OnlineSessionSettings.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsLog.h"
+#include "Containers/Ticker.h"
+#include "Async/Async.h"
+#include "Tasks/Task.h"
+#include "Icmp.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "OnlineBeaconHost.h"
+#include "PartyBeaconClient.h"
+#include "PartyBeaconHost.h"
+#include "PartyBeaconState.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameMapsSettings.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Stats/Stats.h"
+
+/**
+ * @brief "stat MultiplayerSessions" shows the game thread cost of each operation, Unreal Insights shows the same scopes,
+ * plus a bookmark and a counter each time the backend answers or a travel starts.
+ */
+DECLARE_STATS_GROUP(TEXT("MultiplayerSessions"), STATGROUP_MultiplayerSessions, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Create"), STAT_MultiplayerSessions_Create, STATGROUP_MultiplayerSessions);
+DECLARE_CYCLE_STAT(TEXT("Find"), STAT_MultiplayerSessions_Find, STATGROUP_MultiplayerSessions);
+DECLARE_CYCLE_STAT(TEXT("Join"), STAT_MultiplayerSessions_Join, STATGROUP_MultiplayerSessions);
+DECLARE_CYCLE_STAT(TEXT("Destroy"), STAT_MultiplayerSessions_Destroy, STATGROUP_MultiplayerSessions);
+DECLARE_CYCLE_STAT(TEXT("Start"), STAT_MultiplayerSessions_Start, STATGROUP_MultiplayerSessions);
+
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_RequestLatency, TEXT("MultiplayerSessions/RequestLatencyMs"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_TravelLatency, TEXT("MultiplayerSessions/TravelLatencyMs"));
+
+namespace
+{
+    UMultiplayerSessionsSubsystem* GetSubsystem(UWorld* _World)
+    {
+        UGameInstance* GameInstance = _World ? _World->GetGameInstance() : nullptr;
+        return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    }
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice StatsCommand(
+        TEXT("MultiplayerSessions.Stats"),
+        TEXT("Print the p50/p95/p99 latencies of the session operations, over the last samples. Add Reset to clear them."),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+        {
+            UMultiplayerSessionsSubsystem* Subsystem = GetSubsystem(World);
+            if(!Subsystem)
+            {
+                Ar.Log(TEXT("No MultiplayerSessionsSubsystem in this world."));
+                return;
+            }
+            Subsystem->GetLatencyStats().Dump(Ar);
+            if(Args.Contains(TEXT("Reset")))
+            {
+                Subsystem->ResetLatencyStats();
+            }
+        }));
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice EventsCommand(
+        TEXT("MultiplayerSessions.Events"),
+        TEXT("Print the last session events (requests, backend answers, failures), oldest first."),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+        {
+            UMultiplayerSessionsSubsystem* Subsystem = GetSubsystem(World);
+            if(!Subsystem)
+            {
+                Ar.Log(TEXT("No MultiplayerSessionsSubsystem in this world."));
+                return;
+            }
+            Subsystem->GetEventLog().Dump(Ar);
+        }));
+
+    FAutoConsoleCommandWithWorldArgsAndOutputDevice StatsCsvCommand(
+        TEXT("MultiplayerSessions.StatsCsv"),
+        TEXT("Write the session operation latencies to a CSV file. Arg: [Path], Saved/Profiling/MultiplayerSessions by default."),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+        {
+            UMultiplayerSessionsSubsystem* Subsystem = GetSubsystem(World);
+            if(!Subsystem)
+            {
+                Ar.Log(TEXT("No MultiplayerSessionsSubsystem in this world."));
+                return;
+            }
+
+            const FString Path = Args.Num() > 0 ? Args[0]
+                : FPaths::Combine(FPaths::ProfilingDir(), TEXT("MultiplayerSessions"), FString::Printf(TEXT("SessionLatency-%s.csv"), *FDateTime::Now().ToString()));
+            if(FFileHelper::SaveStringToFile(Subsystem->GetLatencyStats().ToCsv(), *Path))
+            {
+                Ar.Logf(TEXT("Session latencies written to %s"), *Path);
+            }
+            else
+            {
+                Ar.Logf(TEXT("Could not write %s"), *Path);
+            }
+        }));
+
+    /**
+     * @brief Filter the results of a search with its query, then index and rank them in a new store. Safe on any thread.
+     * @param _PreviousResults Results cached for the query, returned as they are if the search found the same sessions
+     * @return nullptr if no result is acceptable.
+     */
+    FSessionResultStorePtr ProcessSearchResults(TArray<FOnlineSessionSearchResult>&& _Results, const FSessionSearchQuery& _Query,
+        TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking, const FSessionResultStorePtr& _PreviousResults)
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(ProcessSearchResults);
+
+        FSessionResultColumns Columns = FSessionResultColumns::Extract(_Results);
+        _Query.Filter(_Results, Columns);
+        if(_Results.Num() == 0)
+        {
+            return nullptr;
+        }
+        if(_PreviousResults.IsValid() && FSessionSearchCache::AreResultsEquivalent(_PreviousResults->GetResults(), _Results))
+        {
+            return _PreviousResults;
+        }
+        return FSessionResultStore::Create(MoveTemp(_Results), MoveTemp(Columns), _IndexedKeys, _Ranking);
+    }
+
+    /**
+     * @brief "Host:Port" => Host and Port. Port is empty if the address has none.
+     */
+    void SplitAddress(const FString& _Address, FString& OutHost, FString& OutPort)
+    {
+        int32 PortSeparator;
+        if(_Address.FindLastChar(TEXT(':'), PortSeparator))
+        {
+            OutHost = _Address.Left(PortSeparator);
+            OutPort = _Address.Mid(PortSeparator + 1);
+            return;
+        }
+        OutHost = _Address;
+        OutPort.Reset();
+    }
+
+    /**
+     * @brief The last label of a host name starts with a letter (example.com, localhost).
+     * IP addresses and platform ids (steam.7656...) don't, there is nothing to look up for them.
+     */
+    bool IsHostName(const FString& _Host)
+    {
+        int32 LastDot;
+        const int32 LabelStart = _Host.FindLastChar(TEXT('.'), LastDot) ? LastDot + 1 : 0;
+        return _Host.IsValidIndex(LabelStart) && FChar::IsAlpha(_Host[LabelStart]);
+    }
+}
 
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
 	// Initialise .h variables (Construct delegates which bind action functions to callback functions)
@@ -11,204 +165,2105 @@ UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
     FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
     JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete)),
     DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
-    StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete))
+    StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete)),
+    UpdateSessionCompleteDelegate(FOnUpdateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnUpdateSessionComplete))
 {
     IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
     if(Subsystem)
     {
-        SessionInterface = Subsystem->GetSessionInterface();
-    }	
+        SessionInterface = Subsystem->GetSessionInterface();
+    }
+}
+
+
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
+    bIsLANSubsystem = Subsystem && Subsystem->GetSubsystemName() == "NULL";
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    SessionProfiles.Build(*Settings, bIsLANSubsystem, IsRunningDedicatedServer());
+    JoinRandom.GenerateNewSeed();
+    RetryRandom.GenerateNewSeed();
+    FindRetryBudget = Settings->MaxFindRetryBudget;
+
+    if(IsRunningDedicatedServer() && Settings->bHostOnDedicatedServerStart)
+    {
+        FString MatchType = Settings->DedicatedServerMatchType;
+        int32 NumPublicConnections = Settings->DedicatedServerNumPublicConnections;
+        FParse::Value(FCommandLine::Get(), TEXT("MatchType="), MatchType);
+        FParse::Value(FCommandLine::Get(), TEXT("NumPublicConnections="), NumPublicConnections);
+        UE_LOG(LogMultiplayerSessions, Log, TEXT("Dedicated server: hosting a '%s' session of %d players."), *MatchType, NumPublicConnections);
+        CreateSession(NumPublicConnections, MatchType);
+    }
+
+    SeamlessTravelStartHandle = FWorldDelegates::OnSeamlessTravelStart.AddUObject(this, &ThisClass::OnSeamlessTravelStart);
+    SeamlessTravelTransitionHandle = FWorldDelegates::OnSeamlessTravelTransition.AddUObject(this, &ThisClass::OnSeamlessTravelTransition);
+    PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+}
+
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+    FWorldDelegates::OnSeamlessTravelStart.Remove(SeamlessTravelStartHandle);
+    FWorldDelegates::OnSeamlessTravelTransition.Remove(SeamlessTravelTransitionHandle);
+    FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+    PreloadedMap = nullptr;
+    PreloadingMapName.Reset();
+    StopPollingFirstResult();
+    StopSearchRetry();
+    StopSearchHedge();
+    ++SearchProcessingId;
+    ++ProbeId;
+    ProbedResults.Reset();
+    ++PrewarmId;
+    PrewarmedConnections.Empty();
+    EndReservation();
+    StopReservationHost();
+    if(QuickMatchDeadlineHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(QuickMatchDeadlineHandle);
+        QuickMatchDeadlineHandle.Reset();
+    }
+    if(OperationTimeoutHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(OperationTimeoutHandle);
+        OperationTimeoutHandle.Reset();
+    }
+    PendingOperations.Empty();
+    CurrentOperation.Reset();
+    StopPrefetch();
+    Super::Deinitialize();
+}
+
+
+/**
+ * @brief Net id of the first local player, nullptr if there is none or if it is not logged in (headless runs, NULL subsystem).
+ * The backend calls then use the local user number 0 instead.
+ */
+FUniqueNetIdPtr UMultiplayerSessionsSubsystem::GetLocalUserId() const
+{
+    if(IsRunningDedicatedServer())
+    {
+        return nullptr; // The server hosts as itself
+    }
+
+    const UWorld* World = GetWorld();
+    const ULocalPlayer* LocalPlayer = World ? World->GetFirstLocalPlayerFromController() : nullptr;
+    if(!LocalPlayer)
+    {
+        return nullptr;
+    }
+    return LocalPlayer->GetPreferredUniqueNetId().GetUniqueNetId();
+}
+
+#if !UE_BUILD_SHIPPING
+bool UMultiplayerSessionsSubsystem::OverrideSessionInterface(IOnlineSessionPtr _SessionInterface, bool _bIsLAN)
+{
+    // The delegate handles are registered on the interface of the running operation
+    if(CurrentOperation.IsSet() || !PendingOperations.IsEmpty())
+    {
+        return false;
+    }
+
+    bool bIsLAN = _bIsLAN;
+    if(_SessionInterface.IsValid())
+    {
+        SessionInterface = _SessionInterface;
+    }
+    else
+    {
+        IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
+        SessionInterface = Subsystem ? Subsystem->GetSessionInterface() : nullptr;
+        bIsLAN = Subsystem && Subsystem->GetSubsystemName() == "NULL";
+    }
+
+    // The host settings depend on it
+    if(bIsLAN != bIsLANSubsystem)
+    {
+        bIsLANSubsystem = bIsLAN;
+        SessionProfiles.Build(*GetDefault<UMultiplayerSessionsSettings>(), bIsLANSubsystem, IsRunningDedicatedServer());
+    }
+    FlushSearchCache();
+    return true;
+}
+#endif
+
+/**
+ * @brief A session was created, joined or started, the travel should follow. The load of its destination ends the travel phase, see OnPostLoadMap.
+ */
+void UMultiplayerSessionsSubsystem::MarkTravelStart(ESessionOperationType _Type)
+{
+    PendingTravelOperation = _Type;
+    PendingTravelStartTime = FPlatformTime::Seconds();
+}
+
+void UMultiplayerSessionsSubsystem::OnSeamlessTravelStart(UWorld* World, const FString& MapName)
+{
+    // A server travel without a session operation before it, e.g. back from the match to the lobby
+    if(PendingTravelOperation == ESessionOperationType::None)
+    {
+        MarkTravelStart(ESessionOperationType::Start);
+    }
+    TRACE_BOOKMARK(TEXT("Sessions: seamless travel to %s"), *MapName);
+}
+
+void UMultiplayerSessionsSubsystem::OnSeamlessTravelTransition(UWorld* World)
+{
+    TRACE_BOOKMARK(TEXT("Sessions: in the transition map, %.1f ms after the travel started"), (FPlatformTime::Seconds() - PendingTravelStartTime) * 1000.0);
+}
+
+bool UMultiplayerSessionsSubsystem::IsTransitionMap(const UWorld* _World)
+{
+    return _World->GetOutermost()->GetName() == UGameMapsSettings::GetGameMapsSettings()->TransitionMap.GetLongPackageName();
+}
+
+void UMultiplayerSessionsSubsystem::EndTravel(const FString& MapName)
+{
+    if(PendingTravelOperation == ESessionOperationType::None)
+    {
+        return;
+    }
+
+    const double Latency = FPlatformTime::Seconds() - PendingTravelStartTime;
+    LatencyStats.Record(PendingTravelOperation, ESessionLatencyPhase::Travel, Latency);
+    TRACE_COUNTER_SET(MultiplayerSessions_TravelLatency, Latency * 1000.0);
+    TRACE_BOOKMARK(TEXT("Sessions: travel to %s, %.1f ms after %s"), *MapName, Latency * 1000.0, LexToString(PendingTravelOperation));
+    PendingTravelOperation = ESessionOperationType::None;
+}
+
+void UMultiplayerSessionsSubsystem::ResetLatencyStats()
+{
+    LatencyStats.Reset();
+}
+
+/**
+ * @brief Log a failed operation with the events which led to it. Only failures pay for the formatting.
+ */
+void UMultiplayerSessionsSubsystem::LogOperationFailure(ESessionOperationType _Type, const TCHAR* _Reason, int32 _Code)
+{
+    EventLog.Record(ESessionEvent::Failed, _Type, _Code);
+    UE_LOG(LogMultiplayerSessions, Warning, TEXT("%s failed: %s (code %d). Last session events:"), LexToString(_Type), _Reason, _Code);
+    EventLog.Dump(*GLog, ELogVerbosity::Warning);
+}
+
+void UMultiplayerSessionsSubsystem::FlushSearchCache()
+{
+    SearchCache.Empty();
+    LastSessionResults.Reset();
+}
+
+/**
+ * @brief Queue an operation, it runs right away if the subsystem is idle.
+ */
+void UMultiplayerSessionsSubsystem::EnqueueOperation(FSessionOperation&& _Operation)
+{
+    if(!_Operation.bIsPrefetch)
+    {
+        YieldPrefetch();
+    }
+
+    _Operation.RequestTime = FPlatformTime::Seconds();
+    EventLog.Record(ESessionEvent::Requested, _Operation.Type);
+    PendingOperations.Add(MoveTemp(_Operation));
+    PumpOperationQueue();
+}
+
+/**
+ * @brief Start the next queued operation if none is waiting for the backend.
+ */
+void UMultiplayerSessionsSubsystem::PumpOperationQueue()
+{
+    if(CurrentOperation.IsSet() || PendingOperations.Num() == 0)
+    {
+        return;
+    }
+
+    CurrentOperation = MoveTemp(PendingOperations[0]);
+    PendingOperations.RemoveAt(0);
+    EventLog.Record(ESessionEvent::Started, CurrentOperation->Type);
+
+    StartOperationTimeout();
+
+    // Execute may end the operation right away (e.g. the backend refused the call), keep the function alive while it runs
+    TFunction<void()> Execute = MoveTemp(CurrentOperation->Execute);
+    Execute();
+}
+
+/**
+ * @brief Mark the running operation as done. Callers broadcast their result, then call PumpOperationQueue,
+ * so listeners see an idle subsystem and the next operation doesn't run in the middle of a broadcast.
+ */
+void UMultiplayerSessionsSubsystem::EndOperation(ESessionOperationType _Type)
+{
+    if(!CurrentOperation.IsSet() || CurrentOperation->Type != _Type)
+    {
+        return;
+    }
+
+    const double Latency = FPlatformTime::Seconds() - CurrentOperation->RequestTime;
+    LatencyStats.Record(_Type, ESessionLatencyPhase::Request, Latency);
+    EventLog.Record(ESessionEvent::Completed, _Type);
+    TRACE_COUNTER_SET(MultiplayerSessions_RequestLatency, Latency * 1000.0);
+    TRACE_BOOKMARK(TEXT("Sessions: %s answered in %.1f ms"), LexToString(_Type), Latency * 1000.0);
+
+    CurrentOperation.Reset();
+    if(OperationTimeoutHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(OperationTimeoutHandle);
+        OperationTimeoutHandle.Reset();
+    }
+}
+
+void UMultiplayerSessionsSubsystem::BroadcastNamedSessionOperation(FName _SessionName, ESessionOperationType _Type, bool _bWasSuccessful)
+{
+    if(FCustomOnNamedSessionOperationCompleteDelegate* Delegate = NamedSessionDelegates.Find(_SessionName))
+    {
+        Delegate->Broadcast(_Type, _bWasSuccessful);
+    }
+}
+
+/**
+ * @brief The backend never answered the running operation: stop listening for it, fail it and run the next one.
+ * @return false, the timeout fires only once.
+ */
+bool UMultiplayerSessionsSubsystem::OnOperationTimeout(float DeltaTime)
+{
+    OperationTimeoutHandle.Reset();
+    if(!CurrentOperation.IsSet())
+    {
+        return false;
+    }
+
+    const ESessionOperationType Type = CurrentOperation->Type;
+    const bool bWasBackgroundRefresh = CurrentOperation->bIsBackgroundRefresh;
+    const FName SessionName = CurrentOperation->SessionName;
+    CurrentOperation.Reset();
+    LatencyStats.RecordTimeout(Type);
+    TRACE_BOOKMARK(TEXT("Sessions: %s timed out"), LexToString(Type));
+    EventLog.Record(ESessionEvent::TimedOut, Type);
+    LogOperationFailure(Type, TEXT("the backend did not answer in time"));
+
+    switch(Type)
+    {
+    case ESessionOperationType::Create:
+        if(SessionInterface)
+        {
+            SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+            SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegateHandle);
+        }
+        RehostSettings.Reset();
+        CustomOnCreateSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, Type, false);
+        break;
+    case ESessionOperationType::Find:
+        StopPollingFirstResult();
+        StopSearchRetry();
+        StopSearchHedge();
+        ++SearchProcessingId;
+        if(SessionInterface)
+        {
+            SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+            SessionInterface->CancelFindSessions();
+        }
+        bIsBackgroundRefresh = false;
+        if(!bWasBackgroundRefresh)
+        {
+            CustomOnFindSessionsCompleteDelegate.Broadcast(LastSearchQuery, nullptr, false);
+        }
+        break;
+    case ESessionOperationType::Join:
+        if(SessionInterface){SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);}
+        CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+        BroadcastNamedSessionOperation(SessionName, Type, false);
+        break;
+    case ESessionOperationType::Destroy:
+        if(SessionInterface){SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);}
+        CustomOnDestroySessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, Type, false);
+        break;
+    case ESessionOperationType::Start:
+        if(SessionInterface){SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);}
+        CustomOnStartSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, Type, false);
+        break;
+    default:
+        break;
+    }
+
+    // Let the quick match fall back to hosting, or give up if hosting is what timed out
+    if(Type == ESessionOperationType::Join && QuickMatchPhase == EQuickMatchPhase::Joining)
+    {
+        OnQuickMatchJoinComplete(EOnJoinSessionCompleteResult::UnknownError);
+    }
+    else if(Type == ESessionOperationType::Create && QuickMatchPhase == EQuickMatchPhase::Hosting)
+    {
+        OnQuickMatchHostComplete(false);
+    }
+
+    PumpOperationQueue();
+    return false;
+}
+
+float UMultiplayerSessionsSubsystem::GetOperationTimeout(ESessionOperationType _Type) const
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    switch(_Type)
+    {
+    case ESessionOperationType::Create:     return Settings->CreateSessionTimeout;
+    case ESessionOperationType::Find:       return Settings->FindSessionsTimeout;
+    case ESessionOperationType::Join:       return Settings->JoinSessionTimeout;
+    case ESessionOperationType::Destroy:    return Settings->DestroySessionTimeout;
+    case ESessionOperationType::Start:      return Settings->StartSessionTimeout;
+    default:                                return 10.f;
+    }
+}
+
+/**
+ * @brief (Re)start the timeout of the running operation, from now.
+ */
+void UMultiplayerSessionsSubsystem::StartOperationTimeout()
+{
+    if(OperationTimeoutHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(OperationTimeoutHandle);
+    }
+    OperationTimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateUObject(this, &ThisClass::OnOperationTimeout), GetOperationTimeout(CurrentOperation->Type));
+}
+
+
+void UMultiplayerSessionsSubsystem::CreateSession(int32 _NumPublicConnections, FString _MatchType, FName _SessionName)
+{
+    if(!SessionInterface.IsValid())
+    {
+        CustomOnCreateSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(_SessionName, ESessionOperationType::Create, false);
+        return;
+    }
+
+    // Shared template of the profile when the capacity matches, a copy of it otherwise
+    EnqueueCreateSession(SessionProfiles.MakeSettings(_MatchType, _NumPublicConnections), _SessionName);
+}
+
+void UMultiplayerSessionsSubsystem::EnqueueCreateSession(TSharedRef<const FOnlineSessionSettings> _SessionSettings, FName _SessionName)
+{
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Create;
+    Operation.SessionName = _SessionName;
+    Operation.Execute = [this, _SessionSettings]()
+    {
+        ExecuteCreateSession(_SessionSettings, false);
+    };
+    EnqueueOperation(MoveTemp(Operation));
+}
+
+void UMultiplayerSessionsSubsystem::ExecuteCreateSession(TSharedRef<const FOnlineSessionSettings> _SessionSettings, bool _bDestroyedExistingSession)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Create);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::ExecuteCreateSession);
+    // Before to create a new session, we need to delete a session with the same name, if she exists
+    const FName SessionName = GetOperationSessionName();
+	FNamedOnlineSession* ExistingSession = SessionInterface->GetNamedSession(SessionName);
+	if(ExistingSession && !_bDestroyedExistingSession)
+	{
+        if(CanUpdateSessionInPlace(*ExistingSession, *_SessionSettings))
+        {
+            ExecuteUpdateSession(*ExistingSession, _SessionSettings);
+        }
+        else
+        {
+            DestroyThenCreateSession(_SessionSettings);
+        }
+        return;
+	}
+
+    if(ExistingSession)
+    {
+        // The old session could not be destroyed
+        EndOperation(ESessionOperationType::Create);
+        LogOperationFailure(ESessionOperationType::Create, TEXT("the previous session could not be destroyed"));
+        CustomOnCreateSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Create, false);
+        if(QuickMatchPhase == EQuickMatchPhase::Hosting)
+        {
+            OnQuickMatchHostComplete(false);
+        }
+        PumpOperationQueue();
+        return;
+    }
+
+    // The interface has a list of "delegates", which are objects which react to events and trigger callback functions
+    CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
+
+    LastSessionSettings = _SessionSettings;
+
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+    const bool bCreateStarted = LocalUserId.IsValid()
+        ? SessionInterface->CreateSession(*LocalUserId, SessionName, *LastSessionSettings)
+        : SessionInterface->CreateSession(0, SessionName, *LastSessionSettings);
+    if(!bCreateStarted)
+    {
+        // Remove the delegate handle from the list if the creation failed
+        SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+
+        // Our own custom delegate broadcast to the UW_Menu
+        EndOperation(ESessionOperationType::Create);
+        LogOperationFailure(ESessionOperationType::Create, TEXT("the backend refused the call"));
+        CustomOnCreateSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Create, false);
+        if(QuickMatchPhase == EQuickMatchPhase::Hosting)
+        {
+            OnQuickMatchHostComplete(false);
+        }
+        PumpOperationQueue();
+    }
+}
+
+void UMultiplayerSessionsSubsystem::DestroyThenCreateSession(TSharedRef<const FOnlineSessionSettings> _SessionSettings)
+{
+    UE_LOG(LogMultiplayerSessions, Log, TEXT("Destroying the previous session before creating the new one."));
+
+    // Run the destroy as the current operation, and create the session right after it
+    FSessionOperation CreateAfterDestroy;
+    CreateAfterDestroy.Type = ESessionOperationType::Create;
+    CreateAfterDestroy.SessionName = CurrentOperation->SessionName;
+    CreateAfterDestroy.bDestroyedExistingSession = true;
+    CreateAfterDestroy.Execute = [this, _SessionSettings]()
+    {
+        ExecuteCreateSession(_SessionSettings, true);
+    };
+    PendingOperations.Insert(MoveTemp(CreateAfterDestroy), 0);
+
+    CurrentOperation->Type = ESessionOperationType::Destroy;
+    ExecuteDestroySession();
+}
+
+/**
+ * @brief Only what the backends let change on a live session: the lobby type, LAN, presence and build id are fixed at creation,
+ * and the new capacity must still hold the players already in.
+ */
+bool UMultiplayerSessionsSubsystem::CanUpdateSessionInPlace(const FNamedOnlineSession& _ExistingSession, const FOnlineSessionSettings& _SessionSettings) const
+{
+    if(!GetDefault<UMultiplayerSessionsSettings>()->bRehostInPlace || !_ExistingSession.bHosting)
+    {
+        return false;
+    }
+
+    switch(_ExistingSession.SessionState)
+    {
+    case EOnlineSessionState::Pending:
+    case EOnlineSessionState::Starting:
+    case EOnlineSessionState::InProgress:
+    case EOnlineSessionState::Ended:
+        break;
+    default:
+        return false; // Being created, ended or destroyed
+    }
+
+    const FOnlineSessionSettings& Current = _ExistingSession.SessionSettings;
+    if(Current.bIsLANMatch != _SessionSettings.bIsLANMatch
+        || Current.bIsDedicated != _SessionSettings.bIsDedicated
+        || Current.bUsesPresence != _SessionSettings.bUsesPresence
+        || Current.bUseLobbiesIfAvailable != _SessionSettings.bUseLobbiesIfAvailable
+        || Current.BuildUniqueId != _SessionSettings.BuildUniqueId)
+    {
+        return false;
+    }
+
+    const int32 TakenSlots = Current.NumPublicConnections - _ExistingSession.NumOpenPublicConnections;
+    return _SessionSettings.NumPublicConnections >= TakenSlots;
+}
+
+void UMultiplayerSessionsSubsystem::ExecuteUpdateSession(const FNamedOnlineSession& _ExistingSession, TSharedRef<const FOnlineSessionSettings> _SessionSettings)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Create);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::ExecuteUpdateSession);
+    UE_LOG(LogMultiplayerSessions, Log, TEXT("Updating the hosted session in place."));
+
+    const int32 TakenSlots = _ExistingSession.SessionSettings.NumPublicConnections - _ExistingSession.NumOpenPublicConnections;
+    const FName SessionName = _ExistingSession.SessionName;
+
+    UpdateSessionCompleteDelegateHandle = SessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegate);
+    RehostSettings = _SessionSettings;
+
+    // The interface copies the settings into the named session, it only wants a mutable reference
+    FOnlineSessionSettings UpdatedSettings = *_SessionSettings;
+    if(!SessionInterface->UpdateSession(SessionName, UpdatedSettings, true))
+    {
+        SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegateHandle);
+        RehostSettings.Reset();
+        DestroyThenCreateSession(_SessionSettings);
+        return;
+    }
+
+    // The backends don't recount the free slots when the capacity changes
+    if(FNamedOnlineSession* Session = SessionInterface->GetNamedSession(SessionName))
+    {
+        Session->NumOpenPublicConnections = FMath::Max(UpdatedSettings.NumPublicConnections - TakenSlots, 0);
+    }
+}
+
+void UMultiplayerSessionsSubsystem::OnUpdateSessionComplete(FName SessionName, bool bWasSuccessfull)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Create);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::OnUpdateSessionComplete);
+    if(CurrentOperation.IsSet() && CurrentOperation->SessionName != SessionName)
+    {
+        return; // Update of another session
+    }
+    if(SessionInterface)
+    {
+        SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegateHandle);
+    }
+
+    TSharedPtr<const FOnlineSessionSettings> Settings = MoveTemp(RehostSettings);
+    if(!CurrentOperation.IsSet() || CurrentOperation->Type != ESessionOperationType::Create || !Settings.IsValid())
+    {
+        return; // Timed out
+    }
+
+    if(!bWasSuccessfull)
+    {
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("In place update of the hosted session failed, destroying and creating it instead."));
+        DestroyThenCreateSession(Settings.ToSharedRef());
+        return;
+    }
+
+    // Same outcome as a create for the listeners
+    LastSessionSettings = Settings;
+    OnCreateSessionComplete(SessionName, true);
+}
+
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessfull)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Create);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::OnCreateSessionComplete);
+    if(CurrentOperation.IsSet() && CurrentOperation->SessionName != SessionName)
+    {
+        return; // Create of another session
+    }
+    if(SessionInterface)
+    {
+        SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+    }
+
+    // Broadcast our own custom delegate to the UW_Menu
+    EndOperation(ESessionOperationType::Create);
+    if(!bWasSuccessfull)
+    {
+        LogOperationFailure(ESessionOperationType::Create, TEXT("the backend could not create the session"));
+    }
+    else if(SessionName == NAME_GameSession && !IsRunningDedicatedServer()) // A dedicated server is already on its map
+    {
+        MarkTravelStart(ESessionOperationType::Create);
+    }
+    CustomOnCreateSessionCompleteDelegate.Broadcast(bWasSuccessfull);
+    BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Create, bWasSuccessfull);
+    if(QuickMatchPhase == EQuickMatchPhase::Hosting)
+    {
+        OnQuickMatchHostComplete(bWasSuccessfull);
+    }
+    PumpOperationQueue();
+}
+
+
+void UMultiplayerSessionsSubsystem::FindSessions(int32 _MaxSearchResult)
+{
+    FSessionSearchQuery Query;
+    Query.MaxSearchResults = _MaxSearchResult;
+    FindSessions(Query);
+}
+
+/**
+ * @brief Find sessions matching a query.
+ * If the same query was answered recently, the cached results are broadcast right away and the search only refreshes them.
+ * A search identical to one already queued or running is merged into it instead of calling the backend twice.
+ */
+void UMultiplayerSessionsSubsystem::FindSessions(const FSessionSearchQuery& _Query)
+{
+    if(!SessionInterface)
+    {
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("FindSessions: no session interface."));
+        CustomOnFindSessionsCompleteDelegate.Broadcast(_Query, nullptr, false);
+		return;
+    }
+
+    bool bIsRefresh = false;
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(Settings->bEnableSearchCache)
+    {
+        SearchCache.SetTimeToLive(Settings->SearchCacheTimeToLive);
+        FSessionResultStorePtr CachedResults = SearchCache.Find(_Query, FPlatformTime::Seconds());
+        if(CachedResults.IsValid())
+        {
+            EventLog.Record(ESessionEvent::CacheHit, ESessionOperationType::Find, CachedResults->Num());
+            LastSessionResults = CachedResults;
+            CustomOnFindSessionsCompleteDelegate.Broadcast(_Query, CachedResults, true);
+            bIsRefresh = true;
+            if(QuickMatchPhase == EQuickMatchPhase::Searching && _Query == QuickMatchQuery)
+            {
+                // Joins right away, no need to refresh the results
+                OnQuickMatchSearchComplete(CachedResults);
+                return;
+            }
+            if(PrefetchQuery.IsSet() && PrefetchQuery.GetValue() == _Query)
+            {
+                // The prefetch refreshes them already
+                return;
+            }
+        }
+    }
+
+    if(CoalesceSearch(_Query, bIsRefresh))
+    {
+        return;
+    }
+
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Find;
+    Operation.Query = _Query;
+    Operation.bIsBackgroundRefresh = bIsRefresh;
+    Operation.Execute = [this, _Query, bIsRefresh]()
+    {
+        StartSessionSearch(_Query, bIsRefresh);
+    };
+    EnqueueOperation(MoveTemp(Operation));
+}
+
+bool UMultiplayerSessionsSubsystem::CoalesceSearch(const FSessionSearchQuery& _Query, bool _bIsBackgroundRefresh)
+{
+    if(CurrentOperation.IsSet() && CurrentOperation->Type == ESessionOperationType::Find && CurrentOperation->Query == _Query)
+    {
+        // The running search now has a listener waiting for it
+        if(!_bIsBackgroundRefresh)
+        {
+            CurrentOperation->bIsBackgroundRefresh = false;
+            CurrentOperation->bIsPrefetch = false;
+            bIsBackgroundRefresh = false;
+        }
+        return true;
+    }
+
+    for(FSessionOperation& Pending : PendingOperations)
+    {
+        if(Pending.Type == ESessionOperationType::Find && Pending.Query == _Query)
+        {
+            if(!_bIsBackgroundRefresh && Pending.bIsBackgroundRefresh)
+            {
+                Pending.bIsBackgroundRefresh = false;
+                Pending.bIsPrefetch = false;
+                Pending.Execute = [this, _Query]()
+                {
+                    StartSessionSearch(_Query, false);
+                };
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void UMultiplayerSessionsSubsystem::StartSessionSearch(const FSessionSearchQuery& _Query, bool _bIsBackgroundRefresh)
+{
+    LastSearchQuery = _Query;
+    bIsBackgroundRefresh = _bIsBackgroundRefresh;
+    NumFindRetries = 0;
+    bIsHedgeSearch = false;
+    bKeptPartialResults = false;
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    FindRetryBudget = FMath::Min(FindRetryBudget + Settings->FindRetryBudgetPerSearch, Settings->MaxFindRetryBudget);
+
+    SendSessionSearch(_Query);
+}
+
+void UMultiplayerSessionsSubsystem::SendSessionSearch(const FSessionSearchQuery& _BackendQuery)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Find);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::SendSessionSearch);
+    FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
+
+	//Find Game Sessions
+	LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
+    _BackendQuery.ApplyTo(*LastSessionSearch); // Filters are done by the backend, not after the results arrive
+    SearchSendTime = FPlatformTime::Seconds();
+
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+    const bool bFindStarted = LocalUserId.IsValid()
+        ? SessionInterface->FindSessions(*LocalUserId, LastSessionSearch.ToSharedRef())
+        : SessionInterface->FindSessions(0, LastSessionSearch.ToSharedRef());
+	if(!bFindStarted)
+    {
+        // Remove the delegate handle from the list if the creation failed
+        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+        if(ScheduleSearchRetry())
+        {
+            return;
+        }
+
+        const bool bWasBackgroundRefresh = bIsBackgroundRefresh;
+        bIsBackgroundRefresh = false;
+        EndOperation(ESessionOperationType::Find);
+        LogOperationFailure(ESessionOperationType::Find, TEXT("the backend refused the call"));
+
+        // Our own custom delegate broadcast to the UW_Menu, the cached results were already sent for a background refresh
+        if(!bWasBackgroundRefresh)
+        {
+            CustomOnFindSessionsCompleteDelegate.Broadcast(LastSearchQuery, nullptr, false);
+        }
+        PumpOperationQueue();
+        return;
+    }
+
+    // Quick play: watch the results while they arrive and stop the search at the first usable one
+    if(_BackendQuery.bStopAtFirstResult)
+    {
+        NumPolledSearchResults = 0;
+        FirstResultTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::PollFirstAcceptableResult), 0.f);
+    }
+    ScheduleSearchHedge();
+
+    UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Searching sessions of MatchType '%s'."), *_BackendQuery.MatchType);
+}
+
+/**
+ * @brief Exponential backoff from FindRetryBaseDelay, part of it random. The operation stays current while it waits,
+ * its timeout is restarted when the search is sent again.
+ */
+bool UMultiplayerSessionsSubsystem::ScheduleSearchRetry()
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(NumFindRetries >= Settings->MaxFindRetries || FindRetryBudget < 1.f)
+    {
+        return false;
+    }
+    FindRetryBudget -= 1.f;
+
+    const float Backoff = FMath::Min(Settings->FindRetryBaseDelay * FMath::Pow(2.f, NumFindRetries), Settings->FindRetryMaxDelay);
+    const float Delay = Backoff * (1.f - Settings->FindRetryJitter * RetryRandom.GetFraction());
+    ++NumFindRetries;
+    EventLog.Record(ESessionEvent::Retried, ESessionOperationType::Find, NumFindRetries);
+    UE_LOG(LogMultiplayerSessions, Warning, TEXT("The search failed, retrying in %.2f s (retry %d of %d)."), Delay, NumFindRetries, Settings->MaxFindRetries);
+
+    StopSearchHedge();
+    if(OperationTimeoutHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(OperationTimeoutHandle);
+        OperationTimeoutHandle.Reset();
+    }
+    SearchRetryHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnSearchRetryDelay), Delay);
+    return true;
+}
+
+/**
+ * @return false, the delay fires only once.
+ */
+bool UMultiplayerSessionsSubsystem::OnSearchRetryDelay(float DeltaTime)
+{
+    SearchRetryHandle.Reset();
+    if(!SessionInterface || !CurrentOperation.IsSet() || CurrentOperation->Type != ESessionOperationType::Find)
+    {
+        return false;
+    }
+
+    StartOperationTimeout();
+    SendSessionSearch(bIsHedgeSearch ? HedgeSearchQuery : LastSearchQuery);
+    return false;
+}
+
+void UMultiplayerSessionsSubsystem::StopSearchRetry()
+{
+    if(SearchRetryHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SearchRetryHandle);
+        SearchRetryHandle.Reset();
+    }
+}
+
+void UMultiplayerSessionsSubsystem::ScheduleSearchHedge()
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(!Settings->bHedgeSearches || bIsHedgeSearch || SearchLatency.Num() < Settings->HedgeMinSamples)
+    {
+        return;
+    }
+
+    StopSearchHedge();
+    SearchHedgeHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnSearchHedgeDelay), SearchLatency.GetPercentile(0.95));
+}
+
+/**
+ * @brief The search is slower than 95% of the last ones. Keep the usable sessions it found so far,
+ * otherwise cancel it and send a narrower search, which the backend answers sooner:
+ * fewer results, more free slots and a ping cap on top of the filters of the query.
+ * @return false, the delay fires only once.
+ */
+bool UMultiplayerSessionsSubsystem::OnSearchHedgeDelay(float DeltaTime)
+{
+    SearchHedgeHandle.Reset();
+
+    // Nobody waits for a background refresh, it can take its time
+    if(!SessionInterface || !IsSearchInProgress() || bIsBackgroundRefresh)
+    {
+        return false;
+    }
+
+    const FSessionSearchQuery& Query = LastSearchQuery;
+    const bool bFoundUsableSession = LastSessionSearch->SearchResults.ContainsByPredicate([&Query](const FOnlineSessionSearchResult& Result)
+    {
+        return Result.IsValid() && Query.IsAcceptable(Result);
+    });
+
+    // Nobody wants the rest of the slow search, stop listening before cancelling it
+    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+    SessionInterface->CancelFindSessions();
+    StopPollingFirstResult();
+    EventLog.Record(ESessionEvent::Hedged, ESessionOperationType::Find, bFoundUsableSession ? 1 : 0);
+
+    if(bFoundUsableSession)
+    {
+        // The backend may still write into the search while cancelling, copy the results we keep
+        TArray<FOnlineSessionSearchResult> FoundSoFar;
+        for(const FOnlineSessionSearchResult& Result : LastSessionSearch->SearchResults)
+        {
+            if(Result.IsValid())
+            {
+                FoundSoFar.Add(Result);
+            }
+        }
+        bKeptPartialResults = true;
+        CompleteSessionSearch(MoveTemp(FoundSoFar), true);
+        return false;
+    }
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    bIsHedgeSearch = true;
+    HedgeSearchQuery = LastSearchQuery;
+    HedgeSearchQuery.MaxSearchResults = FMath::Min(HedgeSearchQuery.MaxSearchResults, Settings->HedgeMaxSearchResults);
+    HedgeSearchQuery.MinOpenSlots = FMath::Max(HedgeSearchQuery.MinOpenSlots, Settings->HedgeMinOpenSlots);
+    HedgeSearchQuery.MaxPingInMs = HedgeSearchQuery.MaxPingInMs > 0 ? FMath::Min(HedgeSearchQuery.MaxPingInMs, Settings->HedgeMaxPingInMs) : Settings->HedgeMaxPingInMs;
+    UE_LOG(LogMultiplayerSessions, Log, TEXT("The search is slow, searching again for at most %d sessions with %d free slots and %d ms of ping."),
+        HedgeSearchQuery.MaxSearchResults, HedgeSearchQuery.MinOpenSlots, HedgeSearchQuery.MaxPingInMs);
+    SendSessionSearch(HedgeSearchQuery);
+    return false;
+}
+
+void UMultiplayerSessionsSubsystem::StopSearchHedge()
+{
+    if(SearchHedgeHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SearchHedgeHandle);
+        SearchHedgeHandle.Reset();
+    }
+}
+
+/**
+ * @brief Ticked while a "stop at first result" search is running.
+ * Backends which report results progressively let us cancel the search as soon as a usable session is known.
+ * @return false to stop ticking.
+ */
+bool UMultiplayerSessionsSubsystem::PollFirstAcceptableResult(float DeltaTime)
+{
+    if(!SessionInterface || !IsSearchInProgress())
+    {
+        // OnFindSessionsComplete handles the end of the search
+        FirstResultTickerHandle.Reset();
+        return false;
+    }
+
+    const TArray<FOnlineSessionSearchResult>& SearchResults = LastSessionSearch->SearchResults;
+    for(; NumPolledSearchResults < SearchResults.Num(); ++NumPolledSearchResults)
+    {
+        const FOnlineSessionSearchResult& Result = SearchResults[NumPolledSearchResults];
+        if(Result.IsValid() && LastSearchQuery.IsAcceptable(Result))
+        {
+            // Nobody wants the rest of the search, stop listening before cancelling it
+            SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+            SessionInterface->CancelFindSessions();
+            FirstResultTickerHandle.Reset();
+            StopSearchHedge();
+
+            // The backend may still write into the search while cancelling, copy the one result we keep
+            TArray<FOnlineSessionSearchResult> FirstResult;
+            FirstResult.Add(Result);
+            CompleteSessionSearch(MoveTemp(FirstResult), true);
+            return false;
+        }
+    }
+    return true;
+}
+
+void UMultiplayerSessionsSubsystem::StopPollingFirstResult()
+{
+    if(FirstResultTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(FirstResultTickerHandle);
+        FirstResultTickerHandle.Reset();
+    }
+}
+
+bool UMultiplayerSessionsSubsystem::IsSearchInProgress() const
+{
+    return LastSessionSearch.IsValid() && LastSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress;
+}
+
+void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessfull)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Find);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::OnFindSessionsComplete);
+    if(SessionInterface)
+    {
+        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+    }
+    StopPollingFirstResult();
+    StopSearchHedge();
+
+    // Without retry left, CompleteSessionSearch fails the search
+    if(!bWasSuccessfull && ScheduleSearchRetry())
+    {
+        return;
+    }
+    if(bWasSuccessfull && !bIsHedgeSearch && NumFindRetries == 0)
+    {
+        SearchLatency.AddSample(FPlatformTime::Seconds() - SearchSendTime);
+    }
+
+    // The search object is not used by the backend anymore, move the results instead of copying them
+    CompleteSessionSearch(MoveTemp(LastSessionSearch->SearchResults), bWasSuccessfull);
+}
+
+/**
+ * @brief Filter, index and rank the results of the current search, then finish it on the game thread.
+ * Large searches are processed on worker threads, the Find operation stays current until they are done.
+ * @param _Results Results of the backend, filtered again here in case the backend ignored some QuerySettings
+ */
+void UMultiplayerSessionsSubsystem::CompleteSessionSearch(TArray<FOnlineSessionSearchResult>&& _Results, bool _bWasSuccessful)
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    const FSessionRanking Ranking = FSessionRanking::FromSettings();
+    FSessionResultStorePtr PreviousResults = SearchCache.FindAny(LastSearchQuery);
+    // The results of a hedge are checked against the filters it was sent with
+    const FSessionSearchQuery& FilterQuery = bIsHedgeSearch ? HedgeSearchQuery : LastSearchQuery;
+
+    if(_Results.Num() < Settings->AsyncResultProcessingThreshold)
+    {
+        FinishSessionSearch(ProcessSearchResults(MoveTemp(_Results), FilterQuery, Settings->IndexedSessionSettingKeys, Ranking, PreviousResults), _bWasSuccessful);
+        return;
+    }
+
+    // The workers get copies, they never touch the subsystem
+    const uint32 ProcessingId = ++SearchProcessingId;
+    TWeakObjectPtr<ThisClass> WeakThis(this);
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, ProcessingId, Results = MoveTemp(_Results), Query = FilterQuery, IndexedKeys = Settings->IndexedSessionSettingKeys,
+        Ranking, PreviousResults = MoveTemp(PreviousResults), _bWasSuccessful]() mutable
+    {
+        FSessionResultStorePtr ProcessedResults = ProcessSearchResults(MoveTemp(Results), Query, IndexedKeys, Ranking, PreviousResults);
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, ProcessingId, ProcessedResults = MoveTemp(ProcessedResults), _bWasSuccessful]()
+        {
+            if(WeakThis.IsValid() && WeakThis->SearchProcessingId == ProcessingId)
+            {
+                WeakThis->FinishSessionSearch(ProcessedResults, _bWasSuccessful);
+            }
+        });
+    });
+}
+
+/**
+ * @brief Store the processed results of the current search in the cache, broadcast them and end the Find operation.
+ * @param _Results nullptr if the search found no acceptable session
+ */
+void UMultiplayerSessionsSubsystem::FinishSessionSearch(const FSessionResultStorePtr& _Results, bool _bWasSuccessful)
+{
+    const bool bWasBackgroundRefresh = bIsBackgroundRefresh;
+    bIsBackgroundRefresh = false;
+    EndOperation(ESessionOperationType::Find);
+
+    if(!_bWasSuccessful)
+    {
+        LogOperationFailure(ESessionOperationType::Find, TEXT("the backend search failed"));
+    }
+
+    const FSessionSearchQuery& Query = LastSearchQuery;
+    EventLog.Record(ESessionEvent::ResultsFrom, ESessionOperationType::Find, bIsHedgeSearch ? 2 : (bKeptPartialResults ? 1 : 0));
+    if(!_Results.IsValid())
+    {
+        // The backend has nothing for this query anymore, don't serve stale results next time.
+        // A hedge found nothing narrower, which says nothing of the whole query
+        if(!bIsHedgeSearch)
+        {
+            SearchCache.Remove(LastSearchQuery);
+        }
+        if(bWasBackgroundRefresh)
+        {
+            CustomOnSessionSearchCacheUpdatedDelegate.Broadcast(Query, nullptr);
+        }
+        else
+        {
+            // Our own custom delegate broadcast to the UW_Menu
+            CustomOnFindSessionsCompleteDelegate.Broadcast(Query, nullptr, false);
+        }
+        if(QuickMatchPhase == EQuickMatchPhase::Searching && Query == QuickMatchQuery)
+        {
+            OnQuickMatchSearchComplete(nullptr);
+        }
+        PumpOperationQueue();
+        return;
+    }
+
+    // Already indexed and ranked, lookups are then done on the index.
+    // The narrower results of a hedge don't stand for the query in the cache
+    const bool bResultsChanged = bIsHedgeSearch || SearchCache.Store(LastSearchQuery, _Results.ToSharedRef(), FPlatformTime::Seconds());
+    LastSessionResults = _Results;
+    if(!bWasBackgroundRefresh || bResultsChanged)
+    {
+        // Before the broadcast, a listener may join right away
+        PrewarmCandidates(LastSessionResults);
+    }
+
+    if(bWasBackgroundRefresh)
+    {
+        if(bResultsChanged)
+        {
+            CustomOnSessionSearchCacheUpdatedDelegate.Broadcast(Query, LastSessionResults);
+        }
+    }
+    else
+    {
+        // Our own custom delegate broadcast to the UW_Menu
+        CustomOnFindSessionsCompleteDelegate.Broadcast(Query, LastSessionResults, _bWasSuccessful);
+    }
+    if(QuickMatchPhase == EQuickMatchPhase::Searching && Query == QuickMatchQuery)
+    {
+        OnQuickMatchSearchComplete(LastSessionResults);
+    }
+    PumpOperationQueue();
+}
+
+void UMultiplayerSessionsSubsystem::CancelSearch(const FSessionSearchQuery& _Query)
+{
+    PendingOperations.RemoveAll([&_Query](const FSessionOperation& Pending)
+    {
+        return Pending.Type == ESessionOperationType::Find && Pending.Query == _Query;
+    });
+
+    if(!CurrentOperation.IsSet() || CurrentOperation->Type != ESessionOperationType::Find || CurrentOperation->Query != _Query)
+    {
+        return;
+    }
+
+    const bool bWasBackgroundRefresh = bIsBackgroundRefresh;
+    bIsBackgroundRefresh = false;
+    StopPollingFirstResult();
+    StopSearchRetry();
+    StopSearchHedge();
+    ++SearchProcessingId;
+    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+    SessionInterface->CancelFindSessions();
+    EndOperation(ESessionOperationType::Find);
+    EventLog.Record(ESessionEvent::Cancelled, ESessionOperationType::Find);
+
+    if(!bWasBackgroundRefresh)
+    {
+        CustomOnFindSessionsCompleteDelegate.Broadcast(_Query, nullptr, false);
+    }
+    PumpOperationQueue();
+}
+
+void UMultiplayerSessionsSubsystem::StartPrefetch(const FSessionSearchQuery& _Query)
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(!SessionInterface || !Settings->bEnableSearchCache)
+    {
+        return; // Nowhere to keep the results
+    }
+
+    StopPrefetch();
+    PrefetchQuery = _Query;
+
+    // Refresh before the cached results expire, or FindSessions would miss them between two prefetches
+    const float Interval = FMath::Min(Settings->PrefetchInterval, Settings->SearchCacheTimeToLive * 0.9f);
+    PrefetchTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnPrefetchTick), FMath::Max(Interval, 1.f));
+    OnPrefetchTick(0.f);
+}
+
+void UMultiplayerSessionsSubsystem::StopPrefetch()
+{
+    if(PrefetchTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(PrefetchTickerHandle);
+        PrefetchTickerHandle.Reset();
+    }
+    YieldPrefetch();
+    PrefetchQuery.Reset();
+}
+
+/**
+ * @brief Queue a background search of the prefetch query, unless the subsystem has something else to do.
+ * @return true to keep ticking.
+ */
+bool UMultiplayerSessionsSubsystem::OnPrefetchTick(float DeltaTime)
+{
+    if(!PrefetchQuery.IsSet())
+    {
+        PrefetchTickerHandle.Reset();
+        return false;
+    }
+    if(CurrentOperation.IsSet() || PendingOperations.Num() > 0 || IsQuickMatchInProgress())
+    {
+        return true; // Low priority, next time
+    }
+
+    const FSessionSearchQuery Query = PrefetchQuery.GetValue();
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Find;
+    Operation.Query = Query;
+    Operation.bIsBackgroundRefresh = true;
+    Operation.bIsPrefetch = true;
+    Operation.Execute = [this, Query]()
+    {
+        StartSessionSearch(Query, true);
+    };
+    EnqueueOperation(MoveTemp(Operation));
+    return true;
+}
+
+/**
+ * @brief Drop the queued prefetch and cancel the running one, so a requested operation doesn't wait behind it.
+ */
+void UMultiplayerSessionsSubsystem::YieldPrefetch()
+{
+    PendingOperations.RemoveAll([](const FSessionOperation& Pending)
+    {
+        return Pending.bIsPrefetch;
+    });
+
+    if(CurrentOperation.IsSet() && CurrentOperation->bIsPrefetch)
+    {
+        const FSessionSearchQuery Query = CurrentOperation->Query; // CancelSearch ends the operation
+        CancelSearch(Query);
+    }
+}
+
+void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& Session, FName _SessionName)
+{
+
+     if(!SessionInterface)
+    {
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("JoinSession: no session interface."));
+        CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+        BroadcastNamedSessionOperation(_SessionName, ESessionOperationType::Join, false);
+		return;
+    }
+
+    // The caller's result may not outlive the queue, keep a copy
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Join;
+    Operation.SessionName = _SessionName;
+    Operation.Execute = [this, Session]()
+    {
+        ExecuteJoinSession(Session);
+    };
+    EnqueueOperation(MoveTemp(Operation));
+}
+
+/**
+ * @brief Join a session of a search result store, without copying it out of the store.
+ */
+void UMultiplayerSessionsSubsystem::JoinSession(const FSessionResultHandle& _SessionHandle, FName _SessionName)
+{
+    if(!SessionInterface || !_SessionHandle.IsValid())
+    {
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("JoinSession: no session interface or invalid session handle."));
+        CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::SessionDoesNotExist);
+        BroadcastNamedSessionOperation(_SessionName, ESessionOperationType::Join, false);
+        return;
+    }
+
+    // The handle keeps the result alive while the operation waits in the queue
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Join;
+    Operation.SessionName = _SessionName;
+    Operation.Execute = [this, _SessionHandle]()
+    {
+        ExecuteJoinSession(*_SessionHandle.Get());
+    };
+    EnqueueOperation(MoveTemp(Operation));
+}
+
+bool UMultiplayerSessionsSubsystem::JoinBestSession(const FSessionResultStorePtr& _SessionResults, const FString& _MatchType)
+{
+    if(!_SessionResults.IsValid())
+    {
+        return false;
+    }
+
+    TConstArrayView<int32> Candidates = _SessionResults->Find(FName("MatchType"), FName(*_MatchType));
+    if(Candidates.Num() == 0)
+    {
+        return false;
+    }
+
+    // Ranked when the results arrived, only the candidates are kept
+    TArray<FRankedSession> RankedSessions = _SessionResults->RankCandidates(Candidates);
+
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(Settings->bProbeTopCandidates && RankedSessions.Num() > 1)
+    {
+        ProbeCandidates(_SessionResults, MoveTemp(RankedSessions));
+        return true;
+    }
+
+    JoinRankedSession(_SessionResults, MoveTemp(RankedSessions));
+    return true;
+}
+
+void UMultiplayerSessionsSubsystem::ProbeCandidates(const FSessionResultStorePtr& _SessionResults, TArray<FRankedSession>&& _RankedSessions)
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+
+    ++ProbeId;
+    ProbedResults = _SessionResults;
+    ProbedSessions = MoveTemp(_RankedSessions);
+
+    // Only the head of the ranking can win, the others keep their advertised ping
+    const int32 NumProbes = FMath::Min(Settings->NumCandidatesToProbe, ProbedSessions.Num());
+    NumPendingProbes = NumProbes;
+
+    for(int32 RankedIndex = 0; RankedIndex < NumProbes; ++RankedIndex)
+    {
+        const FOnlineSessionSearchResult& Result = ProbedResults->GetResults()[ProbedSessions[RankedIndex].Index];
+
+        // Warmed up since the search completed, no need to wait for another echo
+        const FPrewarmedConnection* Prewarmed = FindPrewarmedConnection(Result.GetSessionIdStr());
+        if(Prewarmed && Prewarmed->PingInMs != INDEX_NONE && FPlatformTime::Seconds() - Prewarmed->PingTime <= Settings->SearchCacheTimeToLive)
+        {
+            OnCandidateProbed(ProbeId, RankedIndex, Prewarmed->PingInMs);
+            continue;
+        }
+
+        FString Address;
+        if(Prewarmed)
+        {
+            Address = Prewarmed->Address;
+        }
+        else if(!SessionInterface->GetResolvedConnectString(Result, NAME_GamePort, Address))
+        {
+            OnCandidateProbed(ProbeId, RankedIndex, INDEX_NONE);
+            continue;
+        }
+
+        // "Host:Port", the echo only needs the host
+        FString Host, Port;
+        SplitAddress(Address, Host, Port);
+
+        TWeakObjectPtr<ThisClass> WeakThis(this);
+        const uint32 CurrentProbeId = ProbeId;
+        FIcmp::IcmpEcho(Host, Settings->ProbeTimeout, [WeakThis, CurrentProbeId, RankedIndex](FIcmpEchoResult EchoResult)
+        {
+            if(WeakThis.IsValid())
+            {
+                const bool bSuccess = EchoResult.Status == EIcmpResponseStatus::Success;
+                WeakThis->OnCandidateProbed(CurrentProbeId, RankedIndex, bSuccess ? FMath::RoundToInt(EchoResult.Time * 1000.f) : INDEX_NONE);
+            }
+        });
+    }
+}
+
+/**
+ * @param _PingInMs Measured ping, INDEX_NONE if the candidate could not be reached (relay, firewall...)
+ */
+void UMultiplayerSessionsSubsystem::OnCandidateProbed(uint32 _ProbeId, int32 _RankedIndex, int32 _PingInMs)
+{
+    if(_ProbeId != ProbeId || !ProbedSessions.IsValidIndex(_RankedIndex))
+    {
+        return;
+    }
+
+    if(_PingInMs != INDEX_NONE)
+    {
+        ProbedSessions[_RankedIndex].PingInMs = _PingInMs;
+    }
+
+    if(--NumPendingProbes == 0)
+    {
+        FinishProbe();
+    }
+}
+
+void UMultiplayerSessionsSubsystem::FinishProbe()
+{
+    FSessionRanking::FromSettings().Rerank(*ProbedResults, ProbedSessions);
+    FSessionResultStorePtr Results = MoveTemp(ProbedResults);
+    TArray<FRankedSession> RankedSessions = MoveTemp(ProbedSessions);
+
+    ++ProbeId;
+    ProbedResults.Reset();
+    ProbedSessions.Empty();
+
+    JoinRankedSession(Results, MoveTemp(RankedSessions));
+}
+
+void UMultiplayerSessionsSubsystem::PrewarmCandidates(const FSessionResultStorePtr& _SessionResults)
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(!Settings->bPrewarmTopCandidates || !SessionInterface || !_SessionResults.IsValid())
+    {
+        return;
+    }
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::PrewarmCandidates);
+
+    // The player joins from the last results, the connections of the older ones are not needed anymore
+    ++PrewarmId;
+    PrewarmedConnections.Reset();
+
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TConstArrayView<FRankedSession> RankedSessions = _SessionResults->GetRankedSessions();
+    const int32 NumCandidates = FMath::Min(Settings->NumCandidatesToPrewarm, RankedSessions.Num());
+    for(int32 RankedIndex = 0; RankedIndex < NumCandidates; ++RankedIndex)
+    {
+        const FOnlineSessionSearchResult& Result = _SessionResults->GetResults()[RankedSessions[RankedIndex].Index];
+        FString Address;
+        if(!SessionInterface->GetResolvedConnectString(Result, NAME_GamePort, Address))
+        {
+            continue;
+        }
+        const FString SessionId = Result.GetSessionIdStr();
+        PrewarmedConnections.Add(SessionId).Address = Address;
+
+        FString Host, Port;
+        SplitAddress(Address, Host, Port);
+        if(!SocketSubsystem || !IsHostName(Host))
+        {
+            WarmUpConnection(SessionId, Address);
+            continue;
+        }
+
+        // The lookup answers on a worker thread
+        TWeakObjectPtr<ThisClass> WeakThis(this);
+        const uint32 CurrentPrewarmId = PrewarmId;
+        SocketSubsystem->GetAddressInfoAsync([WeakThis, CurrentPrewarmId, SessionId, Port](FAddressInfoResult LookupResult)
+        {
+            FString ResolvedAddress;
+            if(LookupResult.ReturnCode == SE_NO_ERROR && LookupResult.Results.Num() > 0)
+            {
+                const TSharedRef<FInternetAddr>& HostAddress = LookupResult.Results[0].Address;
+                if(!Port.IsEmpty())
+                {
+                    HostAddress->SetPort(FCString::Atoi(*Port));
+                }
+                ResolvedAddress = HostAddress->ToString(!Port.IsEmpty());
+            }
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, CurrentPrewarmId, SessionId, ResolvedAddress]()
+            {
+                if(WeakThis.IsValid())
+                {
+                    WeakThis->OnPrewarmHostResolved(CurrentPrewarmId, SessionId, ResolvedAddress);
+                }
+            });
+        }, *Host, nullptr, EAddressInfoFlags::Default, NAME_None, SOCKTYPE_Datagram);
+    }
+}
+
+/**
+ * @param _Address "IP:Port", empty if the lookup failed
+ */
+void UMultiplayerSessionsSubsystem::OnPrewarmHostResolved(uint32 _PrewarmId, const FString& _SessionId, const FString& _Address)
+{
+    FPrewarmedConnection* Connection = _PrewarmId == PrewarmId ? PrewarmedConnections.Find(_SessionId) : nullptr;
+    if(!Connection)
+    {
+        return;
+    }
+
+    // Otherwise the host name is kept, the travel looks it up again
+    if(!_Address.IsEmpty())
+    {
+        UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Prewarmed session %s: %s resolved to %s."), *_SessionId, *Connection->Address, *_Address);
+        Connection->Address = _Address;
+    }
+    WarmUpConnection(_SessionId, Connection->Address);
+}
+
+void UMultiplayerSessionsSubsystem::WarmUpConnection(const FString& _SessionId, const FString& _Address)
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(!Settings->bWarmUpConnections)
+    {
+        return;
+    }
+
+    FString Host, Port;
+    SplitAddress(_Address, Host, Port);
+
+    TWeakObjectPtr<ThisClass> WeakThis(this);
+    const uint32 CurrentPrewarmId = PrewarmId;
+    FIcmp::IcmpEcho(Host, Settings->ProbeTimeout, [WeakThis, CurrentPrewarmId, _SessionId](FIcmpEchoResult EchoResult)
+    {
+        if(!WeakThis.IsValid() || WeakThis->PrewarmId != CurrentPrewarmId || EchoResult.Status != EIcmpResponseStatus::Success)
+        {
+            return;
+        }
+        if(FPrewarmedConnection* Connection = WeakThis->PrewarmedConnections.Find(_SessionId))
+        {
+            Connection->PingInMs = FMath::RoundToInt(EchoResult.Time * 1000.f);
+            Connection->PingTime = FPlatformTime::Seconds();
+        }
+    });
 }
 
+const FPrewarmedConnection* UMultiplayerSessionsSubsystem::FindPrewarmedConnection(const FString& _SessionId) const
+{
+    return PrewarmedConnections.Find(_SessionId);
+}
 
-void UMultiplayerSessionsSubsystem::CreateSession(int32 _NumPublicConnections, FString _MatchType)
+void UMultiplayerSessionsSubsystem::JoinRankedSession(const FSessionResultStorePtr& _SessionResults, TArray<FRankedSession>&& _RankedSessions)
 {
-    if(!SessionInterface.IsValid())
+    const int32 Picked = FSessionRanking::FromSettings().PickSpread(*_SessionResults, _RankedSessions, JoinRandom);
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(!Settings->bReserveSlotBeforeJoin)
     {
+        JoinSession(_SessionResults->MakeHandle(_RankedSessions[Picked].Index));
         return;
     }
 
-    // Before to create a new session, we need to delete a session with the same name, if she exists
-	FNamedOnlineSession* ExistingSession = SessionInterface->GetNamedSession(NAME_GameSession);
-	if(ExistingSession)
-	{
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Start destroying an old session.")));}
-        bCreateSessionOnDestroy = true;
-	    LastNumPublicConnections = _NumPublicConnections;
-	    LastMatchType = _MatchType;
-        DestroySession();
-	} 
-    else
+    // The picked one first, then the others from the best
+    EndReservation();
+    ReservationResults = _SessionResults;
+    ReservationCandidates.Reset();
+    ReservationCandidates.Add(_RankedSessions[Picked].Index);
+    for(int32 Position = 0; Position < _RankedSessions.Num() && ReservationCandidates.Num() < Settings->MaxReservationAttempts; ++Position)
     {
-        // The interface has a list of "delegates", which are objects which react to events and trigger callback functions
-        CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
-
-        LastSessionSettings = MakeShareable(new FOnlineSessionSettings()); // MakeShareable allows to init SharedPointer, we give it a constructor as a parameter
-        LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
-        LastSessionSettings->NumPublicConnections = _NumPublicConnections;
-        LastSessionSettings->bAllowJoinInProgress = true; // Allow player s to join even if the session started
-        LastSessionSettings->bAllowJoinViaPresence = true; // Allows Steam to let players of the closest region join the server
-        LastSessionSettings->bShouldAdvertise = true; // Allows Steam to advertise the session
-        LastSessionSettings->bUsesPresence = true; // Allows Steam to search players which belongs to the region of the server in priority
-        LastSessionSettings->bUseLobbiesIfAvailable = true; 
-        LastSessionSettings->Set(FName("MatchType"), _MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
-        LastSessionSettings->BuildUniqueId = 1; // Allow to find other hosted sessions
-
-        const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-        if(!SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings))
+        if(Position != Picked)
         {
-            // Remove the delegate handle from the list if the creation failed
-            SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
-
-            // Our own custom delegate broadcast to the UW_Menu
-            CustomOnCreateSessionCompleteDelegate.Broadcast(false);
+            ReservationCandidates.Add(_RankedSessions[Position].Index);
         }
     }
+    NextReservationCandidate = 0;
+    ReserveNextCandidate();
 }
 
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessfull)
+void UMultiplayerSessionsSubsystem::ReserveNextCandidate()
 {
-    if(SessionInterface)
+    if(!ReservationCandidates.IsValidIndex(NextReservationCandidate))
     {
-        SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+        EndReservation();
+        LogOperationFailure(ESessionOperationType::Join, TEXT("every candidate denied the slot reservation"));
+        CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::SessionIsFull);
+        BroadcastNamedSessionOperation(NAME_GameSession, ESessionOperationType::Join, false);
+        if(QuickMatchPhase == EQuickMatchPhase::Joining)
+        {
+            OnQuickMatchJoinComplete(EOnJoinSessionCompleteResult::SessionIsFull);
+        }
+        return;
     }
 
-    // Broadcast our own custom delegate to the UW_Menu
-    CustomOnCreateSessionCompleteDelegate.Broadcast(bWasSuccessfull);
-}
+    const FOnlineSessionSearchResult& Candidate = ReservationResults->GetResults()[ReservationCandidates[NextReservationCandidate++]];
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+    UWorld* World = GetWorld();
+    APartyBeaconClient* Client = World && LocalUserId.IsValid() ? World->SpawnActor<APartyBeaconClient>() : nullptr;
+
+    const uint32 CurrentReservationId = ++ReservationId;
+    if(!Client)
+    {
+        // No player id to reserve for
+        OnReservationHostUnreachable(CurrentReservationId);
+        return;
+    }
+    ReservationClient = Client;
+    Client->OnReservationRequestComplete().BindWeakLambda(this, [this, CurrentReservationId](EPartyReservationResult::Type Result)
+    {
+        OnReservationComplete(CurrentReservationId, Result == EPartyReservationResult::ReservationAccepted || Result == EPartyReservationResult::ReservationDuplicate);
+    });
+    Client->OnHostConnectionFailure().BindWeakLambda(this, [this, CurrentReservationId]()
+    {
+        OnReservationHostUnreachable(CurrentReservationId);
+    });
 
+    TArray<FPlayerReservation> PartyMembers;
+    FPlayerReservation& Reservation = PartyMembers.AddDefaulted_GetRef();
+    Reservation.UniqueId = FUniqueNetIdRepl(LocalUserId);
+    if(!Client->RequestReservation(Candidate, Reservation.UniqueId, PartyMembers))
+    {
+        OnReservationHostUnreachable(CurrentReservationId);
+        return;
+    }
 
-void UMultiplayerSessionsSubsystem::FindSessions(int32 _MaxSearchResult)
+    ReservationTimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this, CurrentReservationId](float)
+    {
+        ReservationTimeoutHandle.Reset();
+        OnReservationHostUnreachable(CurrentReservationId);
+        return false;
+    }), GetDefault<UMultiplayerSessionsSettings>()->ReservationTimeout);
+}
+
+void UMultiplayerSessionsSubsystem::OnReservationComplete(uint32 _ReservationId, bool _bAccepted)
 {
-    if(!SessionInterface)
+    if(_ReservationId != ReservationId)
     {
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Session Interface  is Invalid.")));}
-		return;    
+        return;
     }
 
-    FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
+    if(!_bAccepted)
+    {
+        UE_LOG(LogMultiplayerSessions, Log, TEXT("Slot reservation denied, trying the next candidate."));
+        if(ReservationTimeoutHandle.IsValid())
+        {
+            FTSTicker::GetCoreTicker().RemoveTicker(ReservationTimeoutHandle);
+            ReservationTimeoutHandle.Reset();
+        }
+        if(ReservationClient.IsValid())
+        {
+            ReservationClient->DestroyBeacon();
+            ReservationClient.Reset();
+        }
+        ReserveNextCandidate();
+        return;
+    }
 
-	//Find Game Sessions
-	LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
-	LastSessionSearch->MaxSearchResults = _MaxSearchResult;
-	LastSessionSearch->bIsLanQuery = false;
-	LastSessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+    const FSessionResultHandle Session = ReservationResults->MakeHandle(ReservationCandidates[NextReservationCandidate - 1]);
+    EndReservation();
+    JoinSession(Session);
+}
 
-	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-	if(!SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef()))
+/**
+ * @brief The host runs no party beacon (older build, reservations off on its side, or not on the lobby map anymore):
+ * join it all the same, the join itself still checks the free slots.
+ */
+void UMultiplayerSessionsSubsystem::OnReservationHostUnreachable(uint32 _ReservationId)
+{
+    if(_ReservationId != ReservationId)
     {
-        // Remove the delegate handle from the list if the creation failed
-        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
-
-        // Our own custom delegate broadcast to the UW_Menu
-        CustomOnFindSessionsCompleteDelegate.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+        return;
     }
+    UE_LOG(LogMultiplayerSessions, Verbose, TEXT("No slot reservation possible, joining without it."));
 
-	if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("FindSessions called.")));}
+    const FSessionResultHandle Session = ReservationResults->MakeHandle(ReservationCandidates[NextReservationCandidate - 1]);
+    EndReservation();
+    JoinSession(Session);
 }
 
-void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessfull)
+void UMultiplayerSessionsSubsystem::EndReservation()
 {
-    if(SessionInterface)
+    ++ReservationId;
+    if(ReservationTimeoutHandle.IsValid())
     {
-        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+        FTSTicker::GetCoreTicker().RemoveTicker(ReservationTimeoutHandle);
+        ReservationTimeoutHandle.Reset();
     }
+    if(ReservationClient.IsValid())
+    {
+        ReservationClient->DestroyBeacon();
+    }
+    ReservationClient.Reset();
+    ReservationResults.Reset();
+    ReservationCandidates.Reset();
+    NextReservationCandidate = 0;
+}
 
-    if(LastSessionSearch->SearchResults.Num() == 0)
+bool UMultiplayerSessionsSubsystem::StartReservationHost(FName _SessionName)
+{
+    UWorld* World = GetWorld();
+    const FNamedOnlineSession* Session = SessionInterface ? SessionInterface->GetNamedSession(_SessionName) : nullptr;
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+    if(!Settings->bReserveSlotBeforeJoin || !World || !Session)
     {
-        // Our own custom delegate broadcast to the UW_Menu
-        CustomOnFindSessionsCompleteDelegate.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
-        return;
+        return false;
+    }
+    StopReservationHost();
+
+    AOnlineBeaconHost* BeaconHost = World->SpawnActor<AOnlineBeaconHost>();
+    if(!BeaconHost || !BeaconHost->InitHost())
+    {
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("The reservation beacon could not listen, players join without reservation."));
+        if(BeaconHost)
+        {
+            BeaconHost->DestroyBeacon();
+        }
+        return false;
+    }
+    if(BeaconHost->GetListenPort() != Settings->ReservationBeaconPort)
+    {
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("The reservation beacon listens on %d but %d is advertised, see ReservationBeaconPort."),
+            BeaconHost->GetListenPort(), Settings->ReservationBeaconPort);
+    }
+
+    // A listen server's own player takes a slot without reservation
+    const int32 MaxReservations = FMath::Max(Session->SessionSettings.NumPublicConnections - (IsRunningDedicatedServer() ? 0 : 1), 1);
+    APartyBeaconHost* PartyHost = World->SpawnActor<APartyBeaconHost>();
+    if(!PartyHost || !PartyHost->InitHostBeacon(1, MaxReservations, MaxReservations, _SessionName))
+    {
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("The reservation host could not start, players join without reservation."));
+        if(PartyHost)
+        {
+            PartyHost->Destroy();
+        }
+        BeaconHost->DestroyBeacon();
+        return false;
     }
+    BeaconHost->RegisterHost(PartyHost);
+    BeaconHost->PauseBeaconRequests(false);
 
-    // Our own custom delegate broadcast to the UW_Menu
-    CustomOnFindSessionsCompleteDelegate.Broadcast(LastSessionSearch->SearchResults, bWasSuccessfull);
+    ReservationBeaconHost = BeaconHost;
+    ReservationHost = PartyHost;
+    UE_LOG(LogMultiplayerSessions, Log, TEXT("Accepting up to %d slot reservations."), MaxReservations);
+    return true;
 }
 
-void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& Session)
+void UMultiplayerSessionsSubsystem::StopReservationHost()
 {
+    if(ReservationBeaconHost.IsValid())
+    {
+        if(ReservationHost.IsValid())
+        {
+            ReservationBeaconHost->UnregisterHost(ReservationHost->GetBeaconType());
+        }
+        ReservationBeaconHost->DestroyBeacon();
+    }
+    if(ReservationHost.IsValid())
+    {
+        ReservationHost->Destroy();
+    }
+    ReservationBeaconHost.Reset();
+    ReservationHost.Reset();
+}
 
-     if(!SessionInterface)
+void UMultiplayerSessionsSubsystem::ReleaseReservation(const FUniqueNetIdRepl& _PlayerId)
+{
+    if(ReservationHost.IsValid() && _PlayerId.IsValid())
     {
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Session Interface  is invalid.")));}
-        CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
-		return;    
+        ReservationHost->HandlePlayerLogout(_PlayerId);
     }
+}
 
+void UMultiplayerSessionsSubsystem::ExecuteJoinSession(const FOnlineSessionSearchResult& Session)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Join);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::ExecuteJoinSession);
     JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+    LastJoinSessionId = Session.GetSessionIdStr();
 
-    if(GEngine)
-    {		
+    // Compiled out with the Verbose level, the MatchType lookup too
+    if(UE_LOG_ACTIVE(LogMultiplayerSessions, Verbose))
+    {
         FString SessionFound_MatchType;
         Session.Session.SessionSettings.Get(FName("MatchType"), SessionFound_MatchType); // MatchType is an OutParameter
-    	GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Green, FString::Printf(TEXT("My User Id : %s."), *Session.GetSessionIdStr()));
-    	GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Green, FString::Printf(TEXT("My User Name : %s."), *Session.Session.OwningUserName));
-    	GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Green, FString::Printf(TEXT("Joining Match type : %s."), *SessionFound_MatchType));
+        UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Joining session %s of %s, MatchType '%s', ping %d ms."),
+            *LastJoinSessionId, *Session.Session.OwningUserName, *SessionFound_MatchType, Session.PingInMs);
     }
-				
-    const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-    if(!SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, Session))
+
+    const FName SessionName = GetOperationSessionName();
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+    const bool bJoinStarted = LocalUserId.IsValid()
+        ? SessionInterface->JoinSession(*LocalUserId, SessionName, Session)
+        : SessionInterface->JoinSession(0, SessionName, Session);
+    if(!bJoinStarted)
     {
         SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Session Interface  is invalid.")));}
+        EndOperation(ESessionOperationType::Join);
+        LogOperationFailure(ESessionOperationType::Join, TEXT("the backend refused the call"));
         CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+        BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Join, false);
+        if(QuickMatchPhase == EQuickMatchPhase::Joining)
+        {
+            OnQuickMatchJoinComplete(EOnJoinSessionCompleteResult::UnknownError);
+        }
+        PumpOperationQueue();
     }
 
 }
 
 void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
 {
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Join);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::OnJoinSessionComplete);
+    if(CurrentOperation.IsSet() && CurrentOperation->SessionName != SessionName)
+    {
+        return; // Join of another session
+    }
+    EndOperation(ESessionOperationType::Join);
     if(!SessionInterface.IsValid())
 	{
-        SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("SessionInterface is invalid.")));}
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("OnJoinSessionComplete: no session interface."));
         CustomOnJoinSessionCompleteDelegate.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+        BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Join, false);
+        PumpOperationQueue();
 		return;
 	}
+    SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+
+    // Don't offer this session again from the cache when the player retries
+    if(Result != EOnJoinSessionCompleteResult::Success)
+    {
+        LogOperationFailure(ESessionOperationType::Join, TEXT("the backend could not join the session"), static_cast<int32>(Result));
+    }
+    if(Result != EOnJoinSessionCompleteResult::Success && Result != EOnJoinSessionCompleteResult::AlreadyInSession)
+    {
+        SearchCache.RemoveSession(LastJoinSessionId, GetDefault<UMultiplayerSessionsSettings>()->IndexedSessionSettingKeys, FSessionRanking::FromSettings());
+    }
+    if(Result == EOnJoinSessionCompleteResult::Success && SessionName == NAME_GameSession)
+    {
+        MarkTravelStart(ESessionOperationType::Join);
+    }
     CustomOnJoinSessionCompleteDelegate.Broadcast(Result);
+    BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Join, Result == EOnJoinSessionCompleteResult::Success);
+    if(QuickMatchPhase == EQuickMatchPhase::Joining)
+    {
+        OnQuickMatchJoinComplete(Result);
+    }
+    PumpOperationQueue();
 }
 
-void UMultiplayerSessionsSubsystem::DestroySession()
+void UMultiplayerSessionsSubsystem::DestroySession(FName _SessionName)
 {
     if(!SessionInterface)
     {
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("DestroySession: no session interface."));
         CustomOnDestroySessionCompleteDelegate.Broadcast(false);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("SessionInterface is invalid.")));}
+        BroadcastNamedSessionOperation(_SessionName, ESessionOperationType::Destroy, false);
         return;
     }
 
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Destroy;
+    Operation.SessionName = _SessionName;
+    Operation.Execute = [this]()
+    {
+        ExecuteDestroySession();
+    };
+    EnqueueOperation(MoveTemp(Operation));
+}
+
+void UMultiplayerSessionsSubsystem::ExecuteDestroySession()
+{
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Destroy);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::ExecuteDestroySession);
     DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
-    
-    if(!SessionInterface->DestroySession(NAME_GameSession))
+
+    const FName SessionName = GetOperationSessionName();
+    if(!SessionInterface->DestroySession(SessionName))
     {
-        CustomOnDestroySessionCompleteDelegate.Broadcast(false);
         SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Failed to destroy the session : %s."), NAME_GameSession));}
+        EndOperation(ESessionOperationType::Destroy);
+        LogOperationFailure(ESessionOperationType::Destroy, TEXT("no session to destroy or the backend refused the call"));
+        CustomOnDestroySessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Destroy, false);
+        PumpOperationQueue();
     }
 }
 
 void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessfull)
 {
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Destroy);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::OnDestroySessionComplete);
+    if(CurrentOperation.IsSet() && CurrentOperation->SessionName != SessionName)
+    {
+        return; // Destroy of another session
+    }
+    EndOperation(ESessionOperationType::Destroy);
     if(!SessionInterface)
     {
-        SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("SessionInterface is invalid.")));}
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("OnDestroySessionComplete: no session interface."));
+        PumpOperationQueue();
         return;
     }
-    if(bWasSuccessfull && bCreateSessionOnDestroy)
+    SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+
+    if(!bWasSuccessfull)
     {
-        bCreateSessionOnDestroy = false;
-        CreateSession(LastNumPublicConnections, LastMatchType);
+        LogOperationFailure(ESessionOperationType::Destroy, TEXT("the backend could not destroy the session"));
     }
+
+    // A create waiting for this destroy is the next queued operation, it fails by itself if the session is still there
     CustomOnDestroySessionCompleteDelegate.Broadcast(bWasSuccessfull);
+    BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Destroy, bWasSuccessfull);
+    PumpOperationQueue();
+}
+
+void UMultiplayerSessionsSubsystem::StartSession(FName _SessionName)
+{
+    if(!SessionInterface)
+    {
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("StartSession: no session interface."));
+        CustomOnStartSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(_SessionName, ESessionOperationType::Start, false);
+        return;
+    }
+
+    FSessionOperation Operation;
+    Operation.Type = ESessionOperationType::Start;
+    Operation.SessionName = _SessionName;
+    Operation.Execute = [this]()
+    {
+        ExecuteStartSession();
+    };
+    EnqueueOperation(MoveTemp(Operation));
 }
 
-void UMultiplayerSessionsSubsystem::StartSession()
+void UMultiplayerSessionsSubsystem::ExecuteStartSession()
 {
-    
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Start);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::ExecuteStartSession);
+    StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);
+
+    const FName SessionName = GetOperationSessionName();
+    if(!SessionInterface->StartSession(SessionName))
+    {
+        SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
+        EndOperation(ESessionOperationType::Start);
+        LogOperationFailure(ESessionOperationType::Start, TEXT("no session to start or the backend refused the call"));
+        CustomOnStartSessionCompleteDelegate.Broadcast(false);
+        BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Start, false);
+        PumpOperationQueue();
+    }
 }
 
 void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessfull)
 {
-    
-}
\ No newline at end of file
+    SCOPE_CYCLE_COUNTER(STAT_MultiplayerSessions_Start);
+    TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::OnStartSessionComplete);
+    if(CurrentOperation.IsSet() && CurrentOperation->SessionName != SessionName)
+    {
+        return; // Start of another session
+    }
+    EndOperation(ESessionOperationType::Start);
+    if(SessionInterface)
+    {
+        SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
+    }
+
+    if(!bWasSuccessfull)
+    {
+        LogOperationFailure(ESessionOperationType::Start, TEXT("the backend could not start the session"));
+    }
+    else if(SessionName == NAME_GameSession)
+    {
+        MarkTravelStart(ESessionOperationType::Start);
+    }
+
+    CustomOnStartSessionCompleteDelegate.Broadcast(bWasSuccessfull);
+    BroadcastNamedSessionOperation(SessionName, ESessionOperationType::Start, bWasSuccessfull);
+    PumpOperationQueue();
+}
+
+void UMultiplayerSessionsSubsystem::RegisterPlayer(const FUniqueNetIdRepl& _PlayerId, FName _SessionName)
+{
+    if(!_PlayerId.IsValid() || !HasNamedSession(_SessionName))
+    {
+        return;
+    }
+    if(!SessionInterface->IsPlayerInSession(_SessionName, *_PlayerId))
+    {
+        SessionInterface->RegisterPlayer(_SessionName, *_PlayerId, false);
+    }
+}
+
+void UMultiplayerSessionsSubsystem::UnregisterPlayer(const FUniqueNetIdRepl& _PlayerId, FName _SessionName)
+{
+    if(!_PlayerId.IsValid() || !HasNamedSession(_SessionName))
+    {
+        return;
+    }
+    if(SessionInterface->IsPlayerInSession(_SessionName, *_PlayerId))
+    {
+        SessionInterface->UnregisterPlayer(_SessionName, *_PlayerId);
+    }
+}
+
+bool UMultiplayerSessionsSubsystem::GetResolvedConnectString(FString& OutAddress, FName _SessionName) const
+{
+    if(!SessionInterface)
+    {
+        return false;
+    }
+
+    const FNamedOnlineSession* Session = SessionInterface->GetNamedSession(_SessionName);
+    const FPrewarmedConnection* Prewarmed = Session ? FindPrewarmedConnection(Session->GetSessionIdStr()) : nullptr;
+    if(Prewarmed)
+    {
+        OutAddress = Prewarmed->Address;
+        return true;
+    }
+    return SessionInterface->GetResolvedConnectString(_SessionName, OutAddress);
+}
+
+bool UMultiplayerSessionsSubsystem::HasNamedSession(FName _SessionName) const
+{
+    return SessionInterface && SessionInterface->GetNamedSession(_SessionName) != nullptr;
+}
+
+void UMultiplayerSessionsSubsystem::PreloadMap(const FString& _MapPackageName)
+{
+    if(_MapPackageName.IsEmpty() || PreloadingMapName == _MapPackageName)
+    {
+        return;
+    }
+
+    PreloadedMap = nullptr;
+    PreloadingMapName = _MapPackageName;
+    const UWorld* World = GetWorld();
+    PreloadingFromMapName = World ? World->GetOutermost()->GetName() : FString();
+    TRACE_BOOKMARK(TEXT("Sessions: preloading %s"), *_MapPackageName);
+    LoadPackageAsync(_MapPackageName, FLoadPackageAsyncDelegate::CreateUObject(this, &ThisClass::OnMapPreloaded), 0, PKG_ContainsMap);
+}
+
+bool UMultiplayerSessionsSubsystem::IsMapPreloaded(const FString& _MapPackageName) const
+{
+    return PreloadedMap && PreloadingMapName == _MapPackageName;
+}
+
+void UMultiplayerSessionsSubsystem::OnMapPreloaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+    if(PackageName.ToString() != PreloadingMapName)
+    {
+        return; // Replaced by another map in the meantime
+    }
+
+    if(Result != EAsyncLoadingResult::Succeeded || !LoadedPackage)
+    {
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("Could not preload %s, it will be loaded on travel."), *PreloadingMapName);
+        PreloadingMapName.Reset();
+        return;
+    }
+
+    UE_LOG(LogMultiplayerSessions, Log, TEXT("%s preloaded."), *PreloadingMapName);
+    PreloadedMap = LoadedPackage;
+}
+
+/**
+ * @brief End of a travel. The world now keeps the preloaded map alive, or we went somewhere else and it is not needed anymore.
+ */
+void UMultiplayerSessionsSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+    // A seamless travel goes through the transition map first, the destination is still to come
+    if(!LoadedWorld || IsTransitionMap(LoadedWorld))
+    {
+        return;
+    }
+
+    EndTravel(LoadedWorld->GetMapName());
+
+    // The map which asked for the preload may broadcast its own load after its BeginPlay
+    if(!PreloadingMapName.IsEmpty() && LoadedWorld->GetOutermost()->GetName() != PreloadingFromMapName)
+    {
+        PreloadedMap = nullptr;
+        PreloadingMapName.Reset();
+    }
+}
+
+
+/**
+ * @brief Find a joinable session and join it, or host one if nothing joinable shows up within the budget.
+ */
+void UMultiplayerSessionsSubsystem::QuickMatch(FString _MatchType, float _Budget, int32 _NumPublicConnections, FString _PathToLobby)
+{
+    if(!SessionInterface || IsQuickMatchInProgress())
+    {
+        CustomOnQuickMatchCompleteDelegate.Broadcast(EQuickMatchResult::Failed);
+        return;
+    }
+
+    QuickMatchPathToLobby = _PathToLobby;
+
+    QuickMatchQuery = FSessionSearchQuery();
+    QuickMatchQuery.MatchType = _MatchType;
+    QuickMatchQuery.MinOpenSlots = 1;
+    QuickMatchQuery.bIsLanQuery = bIsLANSubsystem;
+    QuickMatchQuery.bStopAtFirstResult = true; // Any joinable session will do
+
+    // Prepare the host settings while the search runs, so falling back to hosting only costs the backend call
+    QuickMatchHostSettings = SessionProfiles.MakeSettings(_MatchType, _NumPublicConnections);
+
+    QuickMatchPhase = EQuickMatchPhase::Searching;
+    QuickMatchDeadlineHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnQuickMatchDeadline), FMath::Max(_Budget, 0.f));
+
+    // May complete right away from the search cache
+    FindSessions(QuickMatchQuery);
+}
+
+void UMultiplayerSessionsSubsystem::OnQuickMatchSearchComplete(const FSessionResultStorePtr& _SessionResults)
+{
+    // CompleteSessionSearch already filtered the results with the quick match query, any of them is joinable.
+    // The budget is the point of a quick match, so one of the best is picked without probing.
+    if(_SessionResults.IsValid() && _SessionResults->Num() > 0)
+    {
+        QuickMatchPhase = EQuickMatchPhase::Joining;
+        JoinRankedSession(_SessionResults, _SessionResults->RankCandidates(TConstArrayView<int32>()));
+        return;
+    }
+
+    StartQuickMatchHost();
+}
+
+void UMultiplayerSessionsSubsystem::OnQuickMatchJoinComplete(EOnJoinSessionCompleteResult::Type _Result)
+{
+    if(_Result != EOnJoinSessionCompleteResult::Success)
+    {
+        // A failed join must not leave the player without a lobby
+        StartQuickMatchHost();
+        return;
+    }
+
+    FString Address;
+    APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
+    if(PlayerController && GetResolvedConnectString(Address))
+    {
+        PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
+        EndQuickMatch(EQuickMatchResult::Joined);
+        return;
+    }
+    EndQuickMatch(EQuickMatchResult::Failed);
+}
+
+void UMultiplayerSessionsSubsystem::OnQuickMatchHostComplete(bool _bWasSuccessful)
+{
+    UWorld* World = GetWorld();
+    if(_bWasSuccessful && World && World->ServerTravel(QuickMatchPathToLobby))
+    {
+        EndQuickMatch(EQuickMatchResult::Hosted);
+        return;
+    }
+    EndQuickMatch(EQuickMatchResult::Failed);
+}
+
+/**
+ * @brief The budget is spent. If we are still searching, stop and host. A running join is left to finish,
+ * it falls back to hosting by itself if it fails.
+ * @return false, the deadline fires only once.
+ */
+bool UMultiplayerSessionsSubsystem::OnQuickMatchDeadline(float DeltaTime)
+{
+    QuickMatchDeadlineHandle.Reset();
+    if(QuickMatchPhase == EQuickMatchPhase::Searching)
+    {
+        StartQuickMatchHost();
+    }
+    return false;
+}
+
+void UMultiplayerSessionsSubsystem::StartQuickMatchHost()
+{
+    // Change the phase first, so the cancelled search is not handled as a quick match result
+    QuickMatchPhase = EQuickMatchPhase::Hosting;
+    CancelSearch(QuickMatchQuery);
+
+    if(QuickMatchDeadlineHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(QuickMatchDeadlineHandle);
+        QuickMatchDeadlineHandle.Reset();
+    }
+
+    EnqueueCreateSession(QuickMatchHostSettings.ToSharedRef(), NAME_GameSession);
+}
+
+void UMultiplayerSessionsSubsystem::EndQuickMatch(EQuickMatchResult _Result)
+{
+    QuickMatchPhase = EQuickMatchPhase::None;
+    QuickMatchHostSettings.Reset();
+    if(QuickMatchDeadlineHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(QuickMatchDeadlineHandle);
+        QuickMatchDeadlineHandle.Reset();
+    }
+    CustomOnQuickMatchCompleteDelegate.Broadcast(_Result);
+}
@@ -0,0 +1,417 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionFlowBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "MultiplayerSessionsSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSessionFlowBenchmark, Log, All);
+
+namespace
+{
+    // A backend answer never takes that long in a benchmark, the flow is stuck
+    constexpr float StepTimeout = 30.f;
+
+    TSharedPtr<FSessionFlowBenchmark> RunningBenchmark;
+
+    /**
+     * @brief Memory the process uses, as reported by the platform. Read on the game thread around each operation:
+     * the allocator is left alone, what the other threads allocate meanwhile counts too, run the benchmark on an idle map.
+     */
+    int64 GetUsedMemory()
+    {
+        return static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+    }
+
+    FAutoConsoleCommandWithWorldAndArgs BenchmarkCommand(
+        TEXT("MultiplayerSessions.Benchmark"),
+        TEXT("Run the session flows against a mock session interface and log their cost. ")
+        TEXT("Args: [Results=100] [Iterations=20] [Latency=0.05] [Spread=0] [Distribution=Fixed|Uniform|LogNormal] [FailureRate=0] [Seed=1234] [MatchType=FreeForAll] [-Quit]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+        {
+            const FString Command = FString::Join(Args, TEXT(" "));
+
+            FSessionFlowBenchmark::FParams Params;
+            FParse::Value(*Command, TEXT("Results="), Params.Mock.NumSearchResults);
+            FParse::Value(*Command, TEXT("Iterations="), Params.Iterations);
+            FParse::Value(*Command, TEXT("Latency="), Params.Mock.Latency.Mean);
+            FParse::Value(*Command, TEXT("Spread="), Params.Mock.Latency.Spread);
+            FParse::Value(*Command, TEXT("FailureRate="), Params.Mock.FailureRate);
+            FParse::Value(*Command, TEXT("Seed="), Params.Mock.Seed);
+            FParse::Value(*Command, TEXT("MatchType="), Params.MatchType);
+            Params.bQuitWhenDone = FParse::Param(*Command, TEXT("Quit"));
+
+            FString Distribution;
+            if(FParse::Value(*Command, TEXT("Distribution="), Distribution))
+            {
+                Params.Mock.Latency.Distribution = Distribution == TEXT("LogNormal") ? EMockLatencyDistribution::LogNormal
+                    : Distribution == TEXT("Uniform") ? EMockLatencyDistribution::Uniform
+                    : EMockLatencyDistribution::Fixed;
+            }
+            Params.Mock.MatchTypes = {Params.MatchType};
+
+            UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+            UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+            if(!Subsystem || !FSessionFlowBenchmark::Start(Subsystem, Params))
+            {
+                UE_LOG(LogSessionFlowBenchmark, Error, TEXT("Could not start the benchmark: no game instance, subsystem busy or benchmark already running."));
+                if(Params.bQuitWhenDone)
+                {
+                    FPlatformMisc::RequestExit(false);
+                }
+            }
+        }));
+}
+
+bool FSessionFlowBenchmark::Start(UMultiplayerSessionsSubsystem* _Subsystem, const FParams& _Params)
+{
+    if(IsRunning())
+    {
+        return false;
+    }
+
+    TSharedRef<FSessionFlowBenchmark> Benchmark = MakeShared<FSessionFlowBenchmark>(_Subsystem, _Params);
+    if(!Benchmark->Begin())
+    {
+        return false;
+    }
+    RunningBenchmark = Benchmark;
+    Benchmark->StartIteration();
+    return true;
+}
+
+bool FSessionFlowBenchmark::IsRunning()
+{
+    return RunningBenchmark.IsValid();
+}
+
+FSessionFlowBenchmark::FSessionFlowBenchmark(UMultiplayerSessionsSubsystem* _Subsystem, const FParams& _Params)
+    : Subsystem(_Subsystem)
+    , Params(_Params)
+{
+}
+
+bool FSessionFlowBenchmark::Begin()
+{
+    // Built before the clock starts, the result count only weighs on the searches
+    MockSession = MakeShared<FMockOnlineSession, ESPMode::ThreadSafe>(Params.Mock);
+    if(!Subsystem->OverrideSessionInterface(MockSession))
+    {
+        return false;
+    }
+
+    TWeakPtr<FSessionFlowBenchmark> WeakThis = AsShared();
+    MockSession->OnOperationHandled = [WeakThis](EMockSessionOperation Operation, bool bSuccess)
+    {
+        if(TSharedPtr<FSessionFlowBenchmark> This = WeakThis.Pin())
+        {
+            This->OnOperationHandled(Operation, bSuccess);
+        }
+    };
+    Subsystem->CustomOnFindSessionsCompleteDelegate.AddSP(this, &FSessionFlowBenchmark::OnFindSessionsComplete);
+
+    UE_LOG(LogSessionFlowBenchmark, Display, TEXT("Session flow benchmark: %d iterations, %d search results, latency %.3f s (spread %.3f), failure rate %.2f, seed %d."),
+        Params.Iterations, Params.Mock.NumSearchResults, Params.Mock.Latency.Mean, Params.Mock.Latency.Spread, Params.Mock.FailureRate, Params.Mock.Seed);
+    return true;
+}
+
+void FSessionFlowBenchmark::StartIteration()
+{
+    if(Iteration >= Params.Iterations)
+    {
+        Finish(false);
+        return;
+    }
+    StartHost();
+}
+
+void FSessionFlowBenchmark::StartHost()
+{
+    SetStep(EStep::HostCreate);
+    BeginOperation(EOperation::Create, [this]()
+    {
+        Subsystem->CreateSession(Params.NumPublicConnections, Params.MatchType);
+    });
+}
+
+void FSessionFlowBenchmark::StartClient()
+{
+    // Every search goes to the backend, the cache would answer the following ones for free
+    Subsystem->FlushSearchCache();
+
+    const FSessionSearchQuery Query = GetSearchQuery();
+    SetStep(EStep::ClientFind);
+    BeginOperation(EOperation::Find, [this, &Query]()
+    {
+        Subsystem->FindSessions(Query);
+    });
+}
+
+FSessionSearchQuery FSessionFlowBenchmark::GetSearchQuery() const
+{
+    FSessionSearchQuery Query;
+    Query.MatchType = Params.MatchType;
+    Query.MinOpenSlots = 1;
+    return Query;
+}
+
+void FSessionFlowBenchmark::OnOperationHandled(EMockSessionOperation _Operation, bool _bSuccess)
+{
+    if(!Subsystem.IsValid())
+    {
+        Finish(true);
+        return;
+    }
+    if(_Operation == EMockSessionOperation::Find && !_bSuccess)
+    {
+        ++NumBackendFindFailures;
+    }
+
+    switch(Step)
+    {
+    case EStep::HostCreate:
+        // A Destroy may run first if a session was left over
+        if(_Operation == EMockSessionOperation::Create)
+        {
+            EndOperation(EOperation::Create, _bSuccess);
+            if(_bSuccess)
+            {
+                SetStep(EStep::HostDestroy);
+                BeginOperation(EOperation::Destroy, [this]() { Subsystem->DestroySession(); });
+            }
+            else
+            {
+                StartClient();
+            }
+        }
+        break;
+
+    case EStep::HostDestroy:
+        if(_Operation == EMockSessionOperation::Destroy)
+        {
+            EndOperation(EOperation::Destroy, _bSuccess);
+            StartClient();
+        }
+        break;
+
+    case EStep::ClientJoin:
+        if(_Operation == EMockSessionOperation::Join)
+        {
+            // What OnJoinSession does before ClientTravel
+            FString Address;
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            const bool bResolved = _bSuccess && MockSession->GetResolvedConnectString(NAME_GameSession, Address);
+            Pending[static_cast<int32>(EOperation::Join)].ApiSeconds += FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+            EndOperation(EOperation::Join, bResolved);
+            EndClientFlow(bResolved);
+
+            if(MockSession->GetNamedSession(NAME_GameSession))
+            {
+                SetStep(EStep::ClientLeave);
+                BeginOperation(EOperation::Destroy, [this]() { Subsystem->DestroySession(); });
+            }
+            else
+            {
+                ++Iteration;
+                StartIteration();
+            }
+        }
+        break;
+
+    case EStep::ClientLeave:
+        if(_Operation == EMockSessionOperation::Destroy)
+        {
+            EndOperation(EOperation::Destroy, _bSuccess);
+            ++Iteration;
+            StartIteration();
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void FSessionFlowBenchmark::OnFindSessionsComplete(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults, bool _bWasSuccessful)
+{
+    if(Step != EStep::ClientFind || !Subsystem.IsValid())
+    {
+        return;
+    }
+    EndOperation(EOperation::Find, _bWasSuccessful);
+    if(_bWasSuccessful)
+    {
+        SearchResultCounts.Add(_SessionResults.IsValid() ? _SessionResults->Num() : 0);
+    }
+
+    SetStep(EStep::ClientJoin);
+    bool bJoinStarted = false;
+    BeginOperation(EOperation::Join, [this, _bWasSuccessful, &_SessionResults, &bJoinStarted]()
+    {
+        bJoinStarted = _bWasSuccessful && Subsystem->JoinBestSession(_SessionResults, Params.MatchType);
+    });
+    if(!bJoinStarted)
+    {
+        EndOperation(EOperation::Join, false);
+        EndClientFlow(false);
+        ++Iteration;
+        StartIteration();
+    }
+}
+
+void FSessionFlowBenchmark::BeginOperation(EOperation _Operation, TFunctionRef<void()> _Call)
+{
+    FPendingOperation& Operation = Pending[static_cast<int32>(_Operation)];
+    Operation.StartCallbackSeconds = MockSession->GetCallbackSeconds();
+    Operation.StartUsedMemory = GetUsedMemory();
+    Operation.StartCycles = FPlatformTime::Cycles64();
+
+    _Call();
+
+    Operation.ApiSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - Operation.StartCycles);
+}
+
+void FSessionFlowBenchmark::EndOperation(EOperation _Operation, bool _bSuccess)
+{
+    const FPendingOperation& Operation = Pending[static_cast<int32>(_Operation)];
+    FOperationStats& OperationStats = Stats[static_cast<int32>(_Operation)];
+    if(!_bSuccess)
+    {
+        ++OperationStats.NumFailures;
+        return;
+    }
+
+    FSample& Sample = OperationStats.Samples.AddDefaulted_GetRef();
+    Sample.LatencySeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - Operation.StartCycles);
+    Sample.GameThreadSeconds = Operation.ApiSeconds + MockSession->GetCallbackSeconds() - Operation.StartCallbackSeconds;
+    Sample.UsedMemoryDelta = GetUsedMemory() - Operation.StartUsedMemory;
+}
+
+void FSessionFlowBenchmark::EndClientFlow(bool _bSuccess)
+{
+    FOperationStats& FlowStats = Stats[static_cast<int32>(EOperation::ClientFlow)];
+    const FOperationStats& FindStats = Stats[static_cast<int32>(EOperation::Find)];
+    const FOperationStats& JoinStats = Stats[static_cast<int32>(EOperation::Join)];
+    if(!_bSuccess || FindStats.Samples.IsEmpty() || JoinStats.Samples.IsEmpty())
+    {
+        ++FlowStats.NumFailures;
+        return;
+    }
+
+    // Both samples were just added. Find started the flow, Join ended it.
+    const FPendingOperation& Find = Pending[static_cast<int32>(EOperation::Find)];
+    FSample& Sample = FlowStats.Samples.AddDefaulted_GetRef();
+    Sample.LatencySeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - Find.StartCycles);
+    Sample.GameThreadSeconds = FindStats.Samples.Last().GameThreadSeconds + JoinStats.Samples.Last().GameThreadSeconds;
+    Sample.UsedMemoryDelta = GetUsedMemory() - Find.StartUsedMemory;
+}
+
+void FSessionFlowBenchmark::SetStep(EStep _Step)
+{
+    Step = _Step;
+    if(StepTimeoutHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(StepTimeoutHandle);
+    }
+    StepTimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSessionFlowBenchmark::OnStepTimeout), StepTimeout);
+}
+
+bool FSessionFlowBenchmark::OnStepTimeout(float DeltaTime)
+{
+    StepTimeoutHandle.Reset();
+    UE_LOG(LogSessionFlowBenchmark, Error, TEXT("Iteration %d is stuck, the subsystem did not call the backend. Aborting."), Iteration);
+    Finish(true);
+    return false;
+}
+
+void FSessionFlowBenchmark::Finish(bool _bAborted)
+{
+    Step = EStep::Done;
+    if(StepTimeoutHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(StepTimeoutHandle);
+        StepTimeoutHandle.Reset();
+    }
+
+    MockSession->OnOperationHandled = nullptr;
+    if(Subsystem.IsValid())
+    {
+        Subsystem->CustomOnFindSessionsCompleteDelegate.RemoveAll(this);
+    }
+    if(Subsystem.IsValid() && !Subsystem->OverrideSessionInterface(nullptr))
+    {
+        UE_LOG(LogSessionFlowBenchmark, Warning, TEXT("The subsystem is still busy, it keeps the mock session interface."));
+    }
+
+    Report();
+    if(_bAborted)
+    {
+        UE_LOG(LogSessionFlowBenchmark, Warning, TEXT("Benchmark aborted after %d iterations."), Iteration);
+    }
+
+    if(Params.OnFinished)
+    {
+        Params.OnFinished(*this, _bAborted);
+    }
+
+    const bool bQuit = Params.bQuitWhenDone;
+    RunningBenchmark.Reset(); // May delete this
+    if(bQuit)
+    {
+        FPlatformMisc::RequestExit(false);
+    }
+}
+
+const TCHAR* FSessionFlowBenchmark::LexOperation(EOperation _Operation)
+{
+    switch(_Operation)
+    {
+    case EOperation::Create:        return TEXT("Create (host flow)");
+    case EOperation::Destroy:       return TEXT("Destroy");
+    case EOperation::Find:          return TEXT("Find");
+    case EOperation::Join:          return TEXT("Join");
+    case EOperation::ClientFlow:    return TEXT("Find + Join (client flow)");
+    default:                        return TEXT("Unknown");
+    }
+}
+
+void FSessionFlowBenchmark::Report() const
+{
+    for(int32 OperationIndex = 0; OperationIndex < static_cast<int32>(EOperation::Num); ++OperationIndex)
+    {
+        const FOperationStats& OperationStats = Stats[OperationIndex];
+        const int32 NumSamples = OperationStats.Samples.Num();
+        if(NumSamples == 0)
+        {
+            UE_LOG(LogSessionFlowBenchmark, Display, TEXT("%-26s no success, %d failed"), LexOperation(static_cast<EOperation>(OperationIndex)), OperationStats.NumFailures);
+            continue;
+        }
+
+        TArray<double> Latencies;
+        Latencies.Reserve(NumSamples);
+        double GameThreadSeconds = 0.0;
+        int64 UsedMemoryDelta = 0;
+        for(const FSample& Sample : OperationStats.Samples)
+        {
+            Latencies.Add(Sample.LatencySeconds);
+            GameThreadSeconds += Sample.GameThreadSeconds;
+            UsedMemoryDelta += Sample.UsedMemoryDelta;
+        }
+        Latencies.Sort();
+
+        UE_LOG(LogSessionFlowBenchmark, Display, TEXT("%-26s %4d ok %3d failed | latency p50 %8.2f ms  p95 %8.2f ms  max %8.2f ms | game thread %7.3f ms/op | used memory %+9.1f KB/op"),
+            LexOperation(static_cast<EOperation>(OperationIndex)), NumSamples, OperationStats.NumFailures,
+            Latencies[NumSamples / 2] * 1000.0, Latencies[FMath::Min(NumSamples * 95 / 100, NumSamples - 1)] * 1000.0, Latencies.Last() * 1000.0,
+            GameThreadSeconds * 1000.0 / NumSamples, UsedMemoryDelta / 1024.0 / NumSamples);
+    }
+}
+
+#endif
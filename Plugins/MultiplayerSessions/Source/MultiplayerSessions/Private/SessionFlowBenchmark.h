@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "MockOnlineSession.h"
+#include "SessionResultStore.h"
+#include "SessionSearchQuery.h"
+
+class UMultiplayerSessionsSubsystem;
+
+/**
+ * @brief Runs the host flow (CreateSession => OnCreateSessionComplete) and the client flow
+ * (FindSessions => JoinSession => resolved connect string) of the subsystem against FMockOnlineSession, and logs per operation
+ * the end-to-end latency, the game thread time spent in the subsystem and how much the memory used by the process grew.
+ * The travels themselves are not run, they would load a map: the flows stop where ServerTravel / ClientTravel would be called.
+ *
+ * Console: MultiplayerSessions.Benchmark [Results=100] [Iterations=20] [Latency=0.05] [Spread=0] [Distribution=Fixed|Uniform|LogNormal]
+ *          [FailureRate=0] [Seed=1234] [MatchType=FreeForAll] [-Quit]
+ * Headless, no Steam needed: UnrealEditor-Cmd MultiplayerShooter.uproject -game -nullrhi -unattended -ExecCmds="MultiplayerSessions.Benchmark Results=100000 -Quit"
+ * Don't run it from the menu map, the menu reacts to the broadcasts of the subsystem and would travel.
+ * The MultiplayerSessions.Benchmark.* automation tests run the same flows and check their outcome.
+ */
+class FSessionFlowBenchmark : public TSharedFromThis<FSessionFlowBenchmark>
+{
+public:
+
+	struct FParams
+	{
+		FMockOnlineSessionConfig Mock;
+		int32 Iterations{20};
+		int32 NumPublicConnections{4};
+		FString MatchType{TEXT("FreeForAll")};
+		bool bQuitWhenDone{false};
+
+		// Called once the benchmark is over, with whether it was aborted, e.g. for a test to check its outcome
+		TFunction<void(const FSessionFlowBenchmark&, bool)> OnFinished;
+	};
+
+	enum class EOperation : uint8
+	{
+		Create,
+		Destroy,
+		Find,
+		Join,
+		ClientFlow,	// Find then Join, up to ClientTravel. The host flow is the Create operation.
+		Num
+	};
+
+	/**
+	 * @return false if a benchmark is already running or if the subsystem is busy.
+	 */
+	static bool Start(UMultiplayerSessionsSubsystem* _Subsystem, const FParams& _Params);
+	static bool IsRunning();
+
+	FSessionFlowBenchmark(UMultiplayerSessionsSubsystem* _Subsystem, const FParams& _Params);
+
+	int32 GetNumSucceeded(EOperation _Operation) const { return Stats[static_cast<int32>(_Operation)].Samples.Num(); }
+	int32 GetNumFailed(EOperation _Operation) const { return Stats[static_cast<int32>(_Operation)].NumFailures; }
+
+	/**
+	 * @brief Number of sessions found by each search that succeeded, after the subsystem filtered them with GetSearchQuery().
+	 */
+	TConstArrayView<int32> GetSearchResultCounts() const { return SearchResultCounts; }
+
+	/**
+	 * @brief Number of searches of the mock that failed, retries included. A Find operation fails only if its last search did.
+	 */
+	int32 GetNumBackendFindFailures() const { return NumBackendFindFailures; }
+	FSessionSearchQuery GetSearchQuery() const;
+	const FMockOnlineSession& GetMockSession() const { return *MockSession; }
+
+private:
+
+	enum class EStep : uint8
+	{
+		HostCreate,
+		HostDestroy,
+		ClientFind,
+		ClientJoin,
+		ClientLeave,
+		Done
+	};
+
+	struct FSample
+	{
+		double LatencySeconds{0.0};
+		double GameThreadSeconds{0.0};
+		int64 UsedMemoryDelta{0};
+	};
+
+	struct FPendingOperation
+	{
+		uint64 StartCycles{0};
+		double StartCallbackSeconds{0.0};
+		int64 StartUsedMemory{0};
+		double ApiSeconds{0.0};
+	};
+
+	struct FOperationStats
+	{
+		TArray<FSample> Samples;
+		int32 NumFailures{0};
+	};
+
+	bool Begin();
+	void StartIteration();
+	void StartHost();
+	void StartClient();
+	void Finish(bool _bAborted);
+
+	/**
+	 * @brief Start measuring _Operation, then run _Call (the subsystem API call) on the clock.
+	 */
+	void BeginOperation(EOperation _Operation, TFunctionRef<void()> _Call);
+	void EndOperation(EOperation _Operation, bool _bSuccess);
+	void EndClientFlow(bool _bSuccess);
+
+	void OnOperationHandled(EMockSessionOperation _Operation, bool _bSuccess);
+
+	/**
+	 * @brief End of the Find step. Large searches are processed on worker threads after the backend answered,
+	 * so the step ends on the broadcast of the subsystem rather than on the answer of the mock.
+	 */
+	void OnFindSessionsComplete(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults, bool _bWasSuccessful);
+	bool OnStepTimeout(float DeltaTime);
+	void SetStep(EStep _Step);
+
+	static const TCHAR* LexOperation(EOperation _Operation);
+	void Report() const;
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+	FParams Params;
+	TSharedPtr<FMockOnlineSession, ESPMode::ThreadSafe> MockSession;
+
+	EStep Step{EStep::HostCreate};
+	int32 Iteration{0};
+	FTSTicker::FDelegateHandle StepTimeoutHandle;
+
+	FPendingOperation Pending[static_cast<int32>(EOperation::Num)];
+	FOperationStats Stats[static_cast<int32>(EOperation::Num)];
+	TArray<int32> SearchResultCounts;
+	int32 NumBackendFindFailures{0};
+};
+
+#endif
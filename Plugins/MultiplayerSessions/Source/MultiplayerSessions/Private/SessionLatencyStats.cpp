@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionLatencyStats.h"
+#include "Misc/OutputDevice.h"
+
+namespace
+{
+    const TCHAR* LexPhase(ESessionLatencyPhase _Phase)
+    {
+        return _Phase == ESessionLatencyPhase::Travel ? TEXT("Travel") : TEXT("Request");
+    }
+
+    double PercentileOfSorted(const TArray<float>& _Sorted, double _Percentile)
+    {
+        // Nearest rank
+        const int32 Rank = FMath::CeilToInt(FMath::Clamp(_Percentile, 0.0, 1.0) * _Sorted.Num());
+        return _Sorted[FMath::Clamp(Rank - 1, 0, _Sorted.Num() - 1)];
+    }
+}
+
+FSessionLatencyHistogram::FSessionLatencyHistogram(int32 _Capacity)
+    : Capacity(FMath::Max(_Capacity, 1))
+{
+}
+
+void FSessionLatencyHistogram::AddSample(double _Seconds)
+{
+    if(Samples.Num() < Capacity)
+    {
+        Samples.Add(static_cast<float>(_Seconds));
+        return;
+    }
+    Samples[NextSample] = static_cast<float>(_Seconds);
+    NextSample = (NextSample + 1) % Capacity;
+}
+
+void FSessionLatencyHistogram::Reset()
+{
+    Samples.Reset();
+    NextSample = 0;
+}
+
+double FSessionLatencyHistogram::GetPercentile(double _Percentile) const
+{
+    if(Samples.Num() == 0)
+    {
+        return 0.0;
+    }
+    TArray<float> Sorted = Samples;
+    Sorted.Sort();
+    return PercentileOfSorted(Sorted, _Percentile);
+}
+
+double FSessionLatencyHistogram::GetMax() const
+{
+    return Samples.Num() > 0 ? FMath::Max(Samples) : 0.0;
+}
+
+void FSessionLatencyHistogram::GetPercentiles(double& OutP50, double& OutP95, double& OutP99) const
+{
+    if(Samples.Num() == 0)
+    {
+        OutP50 = OutP95 = OutP99 = 0.0;
+        return;
+    }
+    TArray<float> Sorted = Samples;
+    Sorted.Sort();
+    OutP50 = PercentileOfSorted(Sorted, 0.50);
+    OutP95 = PercentileOfSorted(Sorted, 0.95);
+    OutP99 = PercentileOfSorted(Sorted, 0.99);
+}
+
+void FSessionLatencyStats::Record(ESessionOperationType _Type, ESessionLatencyPhase _Phase, double _Seconds)
+{
+    Histograms[static_cast<int32>(_Type)][static_cast<int32>(_Phase)].AddSample(_Seconds);
+}
+
+void FSessionLatencyStats::RecordTimeout(ESessionOperationType _Type)
+{
+    ++NumTimeouts[static_cast<int32>(_Type)];
+}
+
+void FSessionLatencyStats::Reset()
+{
+    for(int32 Type = 0; Type < NumTypes; ++Type)
+    {
+        for(int32 Phase = 0; Phase < NumPhases; ++Phase)
+        {
+            Histograms[Type][Phase].Reset();
+        }
+        NumTimeouts[Type] = 0;
+    }
+}
+
+const FSessionLatencyHistogram& FSessionLatencyStats::Get(ESessionOperationType _Type, ESessionLatencyPhase _Phase) const
+{
+    return Histograms[static_cast<int32>(_Type)][static_cast<int32>(_Phase)];
+}
+
+FString FSessionLatencyStats::ToCsv() const
+{
+    FString Csv = TEXT("Operation,Phase,Samples,Timeouts,P50Ms,P95Ms,P99Ms,MaxMs\n");
+
+    // None is not an operation
+    for(int32 Type = 1; Type < NumTypes; ++Type)
+    {
+        for(int32 Phase = 0; Phase < NumPhases; ++Phase)
+        {
+            const FSessionLatencyHistogram& Histogram = Histograms[Type][Phase];
+            double P50, P95, P99;
+            Histogram.GetPercentiles(P50, P95, P99);
+            Csv += FString::Printf(TEXT("%s,%s,%d,%d,%.2f,%.2f,%.2f,%.2f\n"),
+                LexToString(static_cast<ESessionOperationType>(Type)), LexPhase(static_cast<ESessionLatencyPhase>(Phase)),
+                Histogram.Num(), NumTimeouts[Type], P50 * 1000.0, P95 * 1000.0, P99 * 1000.0, Histogram.GetMax() * 1000.0);
+        }
+    }
+    return Csv;
+}
+
+void FSessionLatencyStats::Dump(FOutputDevice& _Ar) const
+{
+    _Ar.Logf(TEXT("%-8s %-8s %7s %8s %10s %10s %10s %10s"), TEXT("Op"), TEXT("Phase"), TEXT("Samples"), TEXT("Timeouts"), TEXT("p50 ms"), TEXT("p95 ms"), TEXT("p99 ms"), TEXT("max ms"));
+    for(int32 Type = 1; Type < NumTypes; ++Type)
+    {
+        for(int32 Phase = 0; Phase < NumPhases; ++Phase)
+        {
+            const FSessionLatencyHistogram& Histogram = Histograms[Type][Phase];
+            if(Histogram.Num() == 0 && (Phase != 0 || NumTimeouts[Type] == 0))
+            {
+                continue;
+            }
+            double P50, P95, P99;
+            Histogram.GetPercentiles(P50, P95, P99);
+            _Ar.Logf(TEXT("%-8s %-8s %7d %8d %10.1f %10.1f %10.1f %10.1f"),
+                LexToString(static_cast<ESessionOperationType>(Type)), LexPhase(static_cast<ESessionLatencyPhase>(Phase)),
+                Histogram.Num(), NumTimeouts[Type], P50 * 1000.0, P95 * 1000.0, P99 * 1000.0, Histogram.GetMax() * 1000.0);
+        }
+    }
+}
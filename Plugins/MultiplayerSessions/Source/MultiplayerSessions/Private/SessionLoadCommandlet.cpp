@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionLoadCommandlet.h"
+
+#if !UE_BUILD_SHIPPING
+#include "StandaloneSessionsInstance.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "SessionLatencyStats.h"
+#include "SessionResultStore.h"
+#include "SessionSearchQuery.h"
+#include "Containers/Ticker.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/Parse.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogSessionLoad, Log, All);
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+    // Time left to the operations in flight once the run is over
+    constexpr double DrainTimeout = 15.0;
+    // The host has that long to create its session
+    constexpr double HostTimeout = 30.0;
+
+    enum class ELoadOperation : uint8
+    {
+        Find,
+        Join,
+        Destroy,
+        Cycle,  // Find + Join + Destroy of one client
+        Num
+    };
+
+    const TCHAR* LexLoadOperation(ELoadOperation _Operation)
+    {
+        switch(_Operation)
+        {
+        case ELoadOperation::Find:      return TEXT("Find");
+        case ELoadOperation::Join:      return TEXT("Join");
+        case ELoadOperation::Destroy:   return TEXT("Destroy");
+        case ELoadOperation::Cycle:     return TEXT("Find + Join + Destroy");
+        default:                        return TEXT("Unknown");
+        }
+    }
+
+    struct FLoadParams
+    {
+        int32 NumClients{16};
+        double Duration{30.0};
+        bool bUseNull{true};
+        bool bKeepSearchCache{false};
+        FString MatchType{TEXT("FreeForAll")};
+        FMockOnlineSessionConfig Mock;
+    };
+
+    struct FLoadStats
+    {
+        // The percentiles are over the last 64k operations of each kind
+        FSessionLatencyHistogram Latencies{1 << 16};
+        int32 NumSucceeded{0};
+        int32 NumFailed{0};
+    };
+
+    /**
+     * @brief Game instance with its own subsystem, running against its own session interface.
+     */
+    bool InitParticipant(FStandaloneSessionsInstance& _Participant, const FLoadParams& _Params, int32 _Index)
+    {
+        if(!_Participant.Init(*FString::Printf(TEXT("SessionLoad%d"), _Index)))
+        {
+            return false;
+        }
+        if(_Params.bUseNull)
+        {
+            return _Participant.UseNullSubsystem();
+        }
+
+        FMockOnlineSessionConfig MockConfig = _Params.Mock;
+        MockConfig.Seed += _Index; // Clients don't fail in lockstep
+        return _Participant.UseMockSession(MockConfig);
+    }
+
+    class FLoadClient : public TSharedFromThis<FLoadClient>
+    {
+    public:
+
+        FLoadClient(const FLoadParams& _Params, FLoadStats* _Stats) : Params(_Params), Stats(_Stats) {}
+
+        FStandaloneSessionsInstance Participant;
+
+        void Start()
+        {
+            UMultiplayerSessionsSubsystem* Subsystem = Participant.Subsystem;
+            Subsystem->CustomOnFindSessionsCompleteDelegate.AddSP(this, &FLoadClient::OnFindSessionsComplete);
+            Subsystem->OnNamedSessionOperationComplete(NAME_GameSession).AddSP(this, &FLoadClient::OnSessionOperationComplete);
+            StartCycle();
+        }
+
+        void Stop()
+        {
+            bStopping = true;
+        }
+
+        void Shutdown()
+        {
+            if(NextStepHandle.IsValid())
+            {
+                FTSTicker::GetCoreTicker().RemoveTicker(NextStepHandle);
+                NextStepHandle.Reset();
+            }
+            if(UMultiplayerSessionsSubsystem* Subsystem = Participant.Subsystem)
+            {
+                Subsystem->CustomOnFindSessionsCompleteDelegate.RemoveAll(this);
+                Subsystem->OnNamedSessionOperationComplete(NAME_GameSession).RemoveAll(this);
+            }
+            Participant.Shutdown();
+        }
+
+        bool IsIdle() const { return Waiting == ELoadOperation::Num && !NextStepHandle.IsValid(); }
+
+    private:
+
+        void StartCycle()
+        {
+            if(bStopping)
+            {
+                return;
+            }
+            UMultiplayerSessionsSubsystem* Subsystem = Participant.Subsystem;
+            if(!Params.bKeepSearchCache)
+            {
+                Subsystem->FlushSearchCache();
+            }
+
+            FSessionSearchQuery Query;
+            Query.MatchType = Params.MatchType;
+            Query.MinOpenSlots = 1;
+            Query.bIsLanQuery = Subsystem->IsLANSubsystem();
+            Query.bStopAtFirstResult = true;
+
+            CycleStartTime = FPlatformTime::Seconds();
+            BeginOperation(ELoadOperation::Find);
+            Subsystem->FindSessions(Query);
+        }
+
+        void OnFindSessionsComplete(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults, bool _bWasSuccessful)
+        {
+            if(Waiting != ELoadOperation::Find)
+            {
+                return;
+            }
+            const bool bFound = _bWasSuccessful && _SessionResults.IsValid() && _SessionResults->Num() > 0;
+            EndOperation(bFound);
+            if(!bFound)
+            {
+                EndCycle(false);
+                return;
+            }
+
+            // A real client joins a frame later at the earliest, and the subsystem is still in its broadcast
+            const FSessionResultHandle Session = _SessionResults->MakeHandle(0);
+            NextStep([this, Session]()
+            {
+                BeginOperation(ELoadOperation::Join);
+                Participant.Subsystem->JoinSession(Session);
+            });
+        }
+
+        void OnSessionOperationComplete(ESessionOperationType _Type, bool _bWasSuccessful)
+        {
+            if(_Type == ESessionOperationType::Join && Waiting == ELoadOperation::Join)
+            {
+                EndOperation(_bWasSuccessful);
+                if(!_bWasSuccessful)
+                {
+                    EndCycle(false);
+                    return;
+                }
+                NextStep([this]()
+                {
+                    BeginOperation(ELoadOperation::Destroy);
+                    Participant.Subsystem->DestroySession();
+                });
+            }
+            else if(_Type == ESessionOperationType::Destroy && Waiting == ELoadOperation::Destroy)
+            {
+                EndOperation(_bWasSuccessful);
+                EndCycle(_bWasSuccessful);
+            }
+        }
+
+        void BeginOperation(ELoadOperation _Operation)
+        {
+            Waiting = _Operation;
+            OperationStartTime = FPlatformTime::Seconds();
+        }
+
+        void EndOperation(bool _bSuccess)
+        {
+            Record(Waiting, _bSuccess, FPlatformTime::Seconds() - OperationStartTime);
+            Waiting = ELoadOperation::Num;
+        }
+
+        void EndCycle(bool _bSuccess)
+        {
+            Record(ELoadOperation::Cycle, _bSuccess, FPlatformTime::Seconds() - CycleStartTime);
+            NextStep([this]() { StartCycle(); });
+        }
+
+        void Record(ELoadOperation _Operation, bool _bSuccess, double _Seconds)
+        {
+            FLoadStats& OperationStats = Stats[static_cast<int32>(_Operation)];
+            if(!_bSuccess)
+            {
+                ++OperationStats.NumFailed;
+                return;
+            }
+            ++OperationStats.NumSucceeded;
+            OperationStats.Latencies.AddSample(_Seconds);
+        }
+
+        void NextStep(TFunction<void()>&& _Step)
+        {
+            NextStepHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSPLambda(this, [this, Step = MoveTemp(_Step)](float)
+            {
+                NextStepHandle.Reset();
+                Step();
+                return false;
+            }));
+        }
+
+        const FLoadParams& Params;
+        FLoadStats* Stats;
+
+        ELoadOperation Waiting{ELoadOperation::Num};
+        double OperationStartTime{0.0};
+        double CycleStartTime{0.0};
+        bool bStopping{false};
+        FTSTicker::FDelegateHandle NextStepHandle;
+    };
+
+    /**
+     * @brief Tick what the engine loop would tick: the tickers of the subsystems and of the online subsystems, and the game thread tasks.
+     * @return false if the engine is exiting.
+     */
+    bool TickFor(double _Seconds, TFunctionRef<bool()> _IsDone)
+    {
+        const double EndTime = FPlatformTime::Seconds() + _Seconds;
+        double LastTime = FPlatformTime::Seconds();
+        while(!_IsDone())
+        {
+            const double Now = FPlatformTime::Seconds();
+            if(Now >= EndTime || IsEngineExitRequested())
+            {
+                return false;
+            }
+            FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+            FTSTicker::GetCoreTicker().Tick(static_cast<float>(Now - LastTime));
+            LastTime = Now;
+            FPlatformProcess::Sleep(0.f);
+        }
+        return true;
+    }
+
+    void Report(const FLoadStats* _Stats, double _Seconds, int32 _NumClients)
+    {
+        UE_LOG(LogSessionLoad, Display, TEXT("%d clients for %.1f s:"), _NumClients, _Seconds);
+        for(int32 OperationIndex = 0; OperationIndex < static_cast<int32>(ELoadOperation::Num); ++OperationIndex)
+        {
+            const FLoadStats& OperationStats = _Stats[OperationIndex];
+            double P50, P95, P99;
+            OperationStats.Latencies.GetPercentiles(P50, P95, P99);
+            UE_LOG(LogSessionLoad, Display, TEXT("%-22s %8.1f ops/s | %7d ok %6d failed | latency p50 %8.2f ms  p95 %8.2f ms  p99 %8.2f ms  max %8.2f ms"),
+                LexLoadOperation(static_cast<ELoadOperation>(OperationIndex)), OperationStats.NumSucceeded / FMath::Max(_Seconds, UE_SMALL_NUMBER),
+                OperationStats.NumSucceeded, OperationStats.NumFailed,
+                P50 * 1000.0, P95 * 1000.0, P99 * 1000.0, OperationStats.Latencies.GetMax() * 1000.0);
+        }
+    }
+}
+#endif
+
+USessionLoadCommandlet::USessionLoadCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 USessionLoadCommandlet::Main(const FString& Params)
+{
+#if UE_BUILD_SHIPPING
+    UE_LOG(LogSessionLoad, Error, TEXT("The session load generator is not available in Shipping."));
+    return 1;
+#else
+    FLoadParams LoadParams;
+    FParse::Value(*Params, TEXT("Clients="), LoadParams.NumClients);
+    FParse::Value(*Params, TEXT("Duration="), LoadParams.Duration);
+    FParse::Value(*Params, TEXT("MatchType="), LoadParams.MatchType);
+    LoadParams.bKeepSearchCache = FParse::Param(*Params, TEXT("KeepSearchCache"));
+
+    FString Backend;
+    if(FParse::Value(*Params, TEXT("Backend="), Backend))
+    {
+        LoadParams.bUseNull = Backend != TEXT("Mock");
+    }
+    FParse::Value(*Params, TEXT("Results="), LoadParams.Mock.NumSearchResults);
+    FParse::Value(*Params, TEXT("Latency="), LoadParams.Mock.Latency.Mean);
+    FParse::Value(*Params, TEXT("Spread="), LoadParams.Mock.Latency.Spread);
+    FParse::Value(*Params, TEXT("FailureRate="), LoadParams.Mock.FailureRate);
+    FParse::Value(*Params, TEXT("Seed="), LoadParams.Mock.Seed);
+    LoadParams.Mock.MatchTypes = {LoadParams.MatchType};
+    LoadParams.NumClients = FMath::Max(LoadParams.NumClients, 1);
+
+    UE_LOG(LogSessionLoad, Display, TEXT("Session load: %d clients, %.1f s, %s backend, MatchType '%s'."),
+        LoadParams.NumClients, LoadParams.Duration, LoadParams.bUseNull ? TEXT("NULL") : TEXT("mock"), *LoadParams.MatchType);
+
+    FLoadStats Stats[static_cast<int32>(ELoadOperation::Num)];
+    TArray<TSharedRef<FLoadClient>> Clients;
+    FStandaloneSessionsInstance Host;
+    int32 ExitCode = 1;
+
+    // Index 0 is the host, the clients follow
+    bool bHostCreated = false;
+    bool bHostAnswered = false;
+    FDelegateHandle HostHandle;
+    if(!InitParticipant(Host, LoadParams, 0))
+    {
+        UE_LOG(LogSessionLoad, Error, TEXT("Could not set up the host."));
+    }
+    else
+    {
+        HostHandle = Host.Subsystem->OnNamedSessionOperationComplete(NAME_GameSession).AddLambda([&bHostCreated, &bHostAnswered](ESessionOperationType Type, bool bWasSuccessful)
+        {
+            if(Type == ESessionOperationType::Create)
+            {
+                bHostCreated = bWasSuccessful;
+                bHostAnswered = true;
+            }
+        });
+        Host.Subsystem->CreateSession(LoadParams.NumClients, LoadParams.MatchType);
+        TickFor(HostTimeout, [&bHostAnswered]() { return bHostAnswered; });
+    }
+
+    if(!bHostCreated)
+    {
+        UE_LOG(LogSessionLoad, Error, TEXT("The host could not create its session."));
+    }
+    else
+    {
+        for(int32 ClientIndex = 1; ClientIndex <= LoadParams.NumClients; ++ClientIndex)
+        {
+            TSharedRef<FLoadClient> Client = MakeShared<FLoadClient>(LoadParams, Stats);
+            if(!InitParticipant(Client->Participant, LoadParams, ClientIndex))
+            {
+                UE_LOG(LogSessionLoad, Error, TEXT("Could not set up client %d."), ClientIndex);
+                Client->Shutdown();
+                continue;
+            }
+            Clients.Add(Client);
+        }
+
+        const double StartTime = FPlatformTime::Seconds();
+        for(const TSharedRef<FLoadClient>& Client : Clients)
+        {
+            Client->Start();
+        }
+        TickFor(LoadParams.Duration, []() { return false; });
+
+        // Let the operations in flight end, so they are counted
+        for(const TSharedRef<FLoadClient>& Client : Clients)
+        {
+            Client->Stop();
+        }
+        const bool bDrained = TickFor(DrainTimeout, [&Clients]()
+        {
+            return !Clients.ContainsByPredicate([](const TSharedRef<FLoadClient>& Client) { return !Client->IsIdle(); });
+        });
+        if(!bDrained)
+        {
+            UE_LOG(LogSessionLoad, Warning, TEXT("Some operations did not end within %.0f s, they are not counted."), DrainTimeout);
+        }
+
+        Report(Stats, FPlatformTime::Seconds() - StartTime, Clients.Num());
+        ExitCode = Clients.Num() > 0 ? 0 : 1;
+    }
+
+    for(const TSharedRef<FLoadClient>& Client : Clients)
+    {
+        Client->Shutdown();
+    }
+    if(Host.Subsystem)
+    {
+        Host.Subsystem->OnNamedSessionOperationComplete(NAME_GameSession).Remove(HostHandle);
+    }
+    Host.Shutdown();
+    return ExitCode;
+#endif
+}
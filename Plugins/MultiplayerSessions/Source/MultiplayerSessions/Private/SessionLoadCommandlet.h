@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SessionLoadCommandlet.generated.h"
+
+/**
+ * @brief Load generator for the subsystem: one host and N simulated clients, each in its own game instance with its own
+ * UMultiplayerSessionsSubsystem, in one headless process. The host creates a session, then every client loops on
+ * FindSessions => JoinSession => DestroySession as fast as the subsystem lets it, for Duration seconds.
+ * Logs per operation the operations per second, the latency percentiles and the failures.
+ *
+ * UnrealEditor-Cmd MultiplayerShooter.uproject -run=SessionLoad [-Clients=16] [-Duration=30] [-Backend=Null|Mock] [-MatchType=FreeForAll] [-KeepSearchCache]
+ *   Mock only: [-Results=100] [-Latency=0.05] [-Spread=0] [-FailureRate=0] [-Seed=1234]
+ *
+ * Null: every participant gets its own NULL subsystem instance and the clients find the host over LAN, so the numbers include
+ * the LAN beacon round trips. Mock: every participant gets its own FMockOnlineSession, which measures the subsystem alone.
+ * Not available in Shipping, the subsystem only accepts another session interface in the other configurations.
+ */
+UCLASS()
+class USessionLoadCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	USessionLoadCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionRanking.h"
+#include "MultiplayerSessionsSettings.h"
+#include "SessionResultStore.h"
+#include "Async/ParallelFor.h"
+
+FSessionRanking FSessionRanking::FromSettings()
+{
+    const UMultiplayerSessionsSettings* Settings = GetDefault<UMultiplayerSessionsSettings>();
+
+    FSessionRanking Ranking;
+    Ranking.PingWeight = Settings->PingWeight;
+    Ranking.OpenSlotsWeight = Settings->OpenSlotsWeight;
+    Ranking.PreferredOpenSlots = FMath::Max(Settings->PreferredOpenSlots, 1);
+    Ranking.FullerLobbyPreference = Settings->FullerLobbyPreference;
+    Ranking.JoinSpreadTolerance = Settings->JoinSpreadTolerance;
+    return Ranking;
+}
+
+float FSessionRanking::Score(const FSessionResultColumns& _Columns, int32 _Index, int32 _PingInMs) const
+{
+    const int32 MaxSlots = _Columns.MaxSlots[_Index];
+    const int32 OpenSlots = _Columns.OpenSlots[_Index];
+
+    // Backends report an unknown ping as MAX_QUERY_PING, it ranks such sessions last without a special case
+    float Score = -PingWeight * FMath::Max(_PingInMs, 0) / 100.f;
+
+    // Saturates: a lobby with plenty of room is not better than one with just enough
+    Score += OpenSlotsWeight * FMath::Min(OpenSlots, PreferredOpenSlots) / static_cast<float>(PreferredOpenSlots);
+
+    if(MaxSlots > 0)
+    {
+        Score += FullerLobbyPreference * FMath::Clamp(MaxSlots - OpenSlots, 0, MaxSlots) / static_cast<float>(MaxSlots);
+    }
+    return Score;
+}
+
+TArray<FRankedSession> FSessionRanking::Rank(const FSessionResultColumns& _Columns) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FSessionRanking::Rank);
+
+    TArray<FRankedSession> RankedSessions;
+    RankedSessions.SetNumUninitialized(_Columns.Num());
+
+    // Each worker writes its own rows, and only reads the columns
+    ParallelFor(TEXT("SessionRanking.Score"), _Columns.Num(), 1024, [this, &_Columns, &RankedSessions](int32 Index)
+    {
+        FRankedSession& RankedSession = RankedSessions[Index];
+        RankedSession.Index = Index;
+        RankedSession.PingInMs = _Columns.PingInMs[Index];
+        RankedSession.Score = Score(_Columns, Index, RankedSession.PingInMs);
+    });
+
+    RankedSessions.StableSort([](const FRankedSession& A, const FRankedSession& B) { return A.Score > B.Score; });
+    return RankedSessions;
+}
+
+void FSessionRanking::Rerank(const FSessionResultStore& _Store, TArray<FRankedSession>& _RankedSessions) const
+{
+    for(FRankedSession& RankedSession : _RankedSessions)
+    {
+        RankedSession.Score = Score(_Store.GetColumns(), RankedSession.Index, RankedSession.PingInMs);
+    }
+    _RankedSessions.StableSort([](const FRankedSession& A, const FRankedSession& B) { return A.Score > B.Score; });
+}
+
+int32 FSessionRanking::PickSpread(const FSessionResultStore& _Store, TConstArrayView<FRankedSession> _RankedSessions, FRandomStream& _Random) const
+{
+    if(_RankedSessions.Num() == 0)
+    {
+        return INDEX_NONE;
+    }
+
+    // Sorted best first, the equivalent candidates are the head
+    const TArray<int32>& OpenSlots = _Store.GetColumns().OpenSlots;
+    const float MinScore = _RankedSessions[0].Score - JoinSpreadTolerance;
+    int32 NumEquivalent = 0;
+    int32 TotalWeight = 0;
+    while(NumEquivalent < _RankedSessions.Num() && _RankedSessions[NumEquivalent].Score >= MinScore)
+    {
+        // A lobby with more room takes more of the arrivals, so they fill at the same pace
+        TotalWeight += FMath::Max(OpenSlots[_RankedSessions[NumEquivalent].Index], 1);
+        ++NumEquivalent;
+    }
+    if(NumEquivalent <= 1)
+    {
+        return 0;
+    }
+
+    int32 Roll = _Random.RandHelper(TotalWeight);
+    for(int32 Position = 0; Position < NumEquivalent; ++Position)
+    {
+        Roll -= FMath::Max(OpenSlots[_RankedSessions[Position].Index], 1);
+        if(Roll < 0)
+        {
+            return Position;
+        }
+    }
+    return NumEquivalent - 1;
+}
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionResultStore.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+namespace
+{
+    std::atomic<uint32> NumSessionResultStoresCreated{0};
+}
+
+const FOnlineSessionSearchResult* FSessionResultHandle::Get() const
+{
+    if(!Store.IsValid() || !Store->GetResults().IsValidIndex(Index))
+    {
+        return nullptr;
+    }
+    return &Store->GetResults()[Index];
+}
+
+FSessionResultColumns FSessionResultColumns::Extract(TConstArrayView<FOnlineSessionSearchResult> _Results)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FSessionResultColumns::Extract);
+
+    FSessionResultColumns Columns;
+    Columns.SetNum(_Results.Num());
+
+    // Each worker writes its own rows, and only reads the results
+    const FName MatchTypeKey("MatchType");
+    ParallelFor(TEXT("SessionResultColumns.Extract"), _Results.Num(), 256, [&Columns, &_Results, MatchTypeKey](int32 Index)
+    {
+        const FOnlineSessionSearchResult& Result = _Results[Index];
+        Columns.PingInMs[Index] = Result.PingInMs;
+        Columns.OpenSlots[Index] = Result.Session.NumOpenPublicConnections;
+        Columns.MaxSlots[Index] = Result.Session.SessionSettings.NumPublicConnections;
+        Columns.BuildUniqueId[Index] = Result.Session.SessionSettings.BuildUniqueId;
+
+        FString MatchType;
+        Result.Session.SessionSettings.Get(MatchTypeKey, MatchType);
+        Columns.MatchTypeHash[Index] = HashMatchType(MatchType);
+    });
+    return Columns;
+}
+
+void FSessionResultColumns::MoveRow(int32 _From, int32 _To)
+{
+    PingInMs[_To] = PingInMs[_From];
+    OpenSlots[_To] = OpenSlots[_From];
+    MaxSlots[_To] = MaxSlots[_From];
+    BuildUniqueId[_To] = BuildUniqueId[_From];
+    MatchTypeHash[_To] = MatchTypeHash[_From];
+}
+
+void FSessionResultColumns::SetNum(int32 _Num)
+{
+    PingInMs.SetNumUninitialized(_Num);
+    OpenSlots.SetNumUninitialized(_Num);
+    MaxSlots.SetNumUninitialized(_Num);
+    BuildUniqueId.SetNumUninitialized(_Num);
+    MatchTypeHash.SetNumUninitialized(_Num);
+}
+
+FSessionResultStoreRef FSessionResultStore::Create(TArray<FOnlineSessionSearchResult>&& _Results, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking)
+{
+    FSessionResultColumns Columns = FSessionResultColumns::Extract(_Results);
+    return Create(MoveTemp(_Results), MoveTemp(Columns), _IndexedKeys, _Ranking);
+}
+
+FSessionResultStoreRef FSessionResultStore::Create(TArray<FOnlineSessionSearchResult>&& _Results, FSessionResultColumns&& _Columns, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking)
+{
+    check(_Columns.Num() == _Results.Num());
+
+    // The constructor is private, so MakeShared can't be used
+    return MakeShareable(new FSessionResultStore(MoveTemp(_Results), MoveTemp(_Columns), _IndexedKeys, _Ranking));
+}
+
+FSessionResultStore::FSessionResultStore(TArray<FOnlineSessionSearchResult>&& _Results, FSessionResultColumns&& _Columns, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking)
+    : Results(MoveTemp(_Results))
+    , Columns(MoveTemp(_Columns))
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FSessionResultStore::Build);
+    ++NumSessionResultStoresCreated;
+
+    RankedSessions = _Ranking.Rank(Columns);
+
+    for(const FName& Key : _IndexedKeys)
+    {
+        Index.Add(Key);
+    }
+
+    for(int32 ResultIndex = 0; ResultIndex < Results.Num(); ++ResultIndex)
+    {
+        const FSessionSettings& Settings = Results[ResultIndex].Session.SessionSettings.Settings;
+        for(TPair<FName, TMap<FName, TArray<int32>>>& KeyIndex : Index)
+        {
+            const FOnlineSessionSetting* Setting = Settings.Find(KeyIndex.Key);
+            if(Setting)
+            {
+                KeyIndex.Value.FindOrAdd(FName(*Setting->Data.ToString())).Add(ResultIndex);
+            }
+        }
+    }
+}
+
+FSessionResultHandle FSessionResultStore::MakeHandle(int32 _Index) const
+{
+    if(!Results.IsValidIndex(_Index))
+    {
+        return FSessionResultHandle();
+    }
+    return FSessionResultHandle(AsShared(), _Index);
+}
+
+TConstArrayView<int32> FSessionResultStore::Find(FName _Key, FName _Value) const
+{
+    const TMap<FName, TArray<int32>>* KeyIndex = Index.Find(_Key);
+    if(!KeyIndex)
+    {
+        return TConstArrayView<int32>();
+    }
+
+    const TArray<int32>* Indices = KeyIndex->Find(_Value);
+    return Indices ? TConstArrayView<int32>(*Indices) : TConstArrayView<int32>();
+}
+
+FSessionResultHandle FSessionResultStore::FindFirst(FName _Key, FName _Value) const
+{
+    TConstArrayView<int32> Indices = Find(_Key, _Value);
+    return Indices.Num() > 0 ? MakeHandle(Indices[0]) : FSessionResultHandle();
+}
+
+TArray<FRankedSession> FSessionResultStore::RankCandidates(TConstArrayView<int32> _Candidates) const
+{
+    if(_Candidates.Num() == 0)
+    {
+        return TArray<FRankedSession>(RankedSessions);
+    }
+
+    TBitArray<> IsCandidate(false, Results.Num());
+    for(int32 Candidate : _Candidates)
+    {
+        if(Results.IsValidIndex(Candidate))
+        {
+            IsCandidate[Candidate] = true;
+        }
+    }
+
+    TArray<FRankedSession> RankedCandidates;
+    RankedCandidates.Reserve(_Candidates.Num());
+    for(const FRankedSession& RankedSession : RankedSessions)
+    {
+        if(IsCandidate[RankedSession.Index])
+        {
+            RankedCandidates.Add(RankedSession);
+        }
+    }
+    return RankedCandidates;
+}
+
+uint32 FSessionResultStore::GetNumCreated()
+{
+    return NumSessionResultStoresCreated;
+}
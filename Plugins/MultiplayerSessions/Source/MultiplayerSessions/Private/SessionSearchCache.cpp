@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSearchCache.h"
+
+FSessionResultStorePtr FSessionSearchCache::Find(const FSessionSearchQuery& _Query, double _Now) const
+{
+    const FEntry* Entry = Entries.Find(_Query);
+    if(!Entry || _Now - Entry->Timestamp > TimeToLive)
+    {
+        return nullptr;
+    }
+    return Entry->Results;
+}
+
+FSessionResultStorePtr FSessionSearchCache::FindAny(const FSessionSearchQuery& _Query) const
+{
+    const FEntry* Entry = Entries.Find(_Query);
+    return Entry ? Entry->Results : nullptr;
+}
+
+bool FSessionSearchCache::Store(const FSessionSearchQuery& _Query, const FSessionResultStoreRef& _Results, double _Now)
+{
+    FEntry& Entry = Entries.FindOrAdd(_Query);
+    Entry.Timestamp = _Now;
+
+    // Only bring in the changes, listeners don't need to hear about an identical refresh
+    if(Entry.Results == _Results)
+    {
+        return false;
+    }
+    Entry.Results = _Results;
+    return true;
+}
+
+void FSessionSearchCache::Remove(const FSessionSearchQuery& _Query)
+{
+    Entries.Remove(_Query);
+}
+
+void FSessionSearchCache::RemoveSession(const FString& _SessionId, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking)
+{
+    for(auto It = Entries.CreateIterator(); It; ++It)
+    {
+        const TArray<FOnlineSessionSearchResult>& OldResults = It->Value.Results->GetResults();
+        if(!OldResults.ContainsByPredicate([&_SessionId](const FOnlineSessionSearchResult& Result) { return Result.GetSessionIdStr() == _SessionId; }))
+        {
+            continue;
+        }
+
+        // Stores are never modified once built, rebuild this one without the session. Only happens after a failed join.
+        TArray<FOnlineSessionSearchResult> NewResults;
+        NewResults.Reserve(OldResults.Num() - 1);
+        for(const FOnlineSessionSearchResult& Result : OldResults)
+        {
+            if(Result.GetSessionIdStr() != _SessionId)
+            {
+                NewResults.Add(Result);
+            }
+        }
+
+        // Nothing left would be served as a successful search with no session, the next search must ask the backend
+        if(NewResults.IsEmpty())
+        {
+            It.RemoveCurrent();
+            continue;
+        }
+        It->Value.Results = FSessionResultStore::Create(MoveTemp(NewResults), _IndexedKeys, _Ranking);
+    }
+}
+
+bool FSessionSearchCache::AreResultsEquivalent(const TArray<FOnlineSessionSearchResult>& A, const TArray<FOnlineSessionSearchResult>& B)
+{
+    if(A.Num() != B.Num())
+    {
+        return false;
+    }
+
+    for(int32 Index = 0; Index < A.Num(); ++Index)
+    {
+        const FOnlineSessionSearchResult& Old = A[Index];
+        const FOnlineSessionSearchResult& New = B[Index];
+        if(Old.PingInMs != New.PingInMs
+            || Old.Session.NumOpenPublicConnections != New.Session.NumOpenPublicConnections
+            || Old.GetSessionIdStr() != New.GetSessionIdStr())
+        {
+            return false;
+        }
+    }
+    return true;
+}
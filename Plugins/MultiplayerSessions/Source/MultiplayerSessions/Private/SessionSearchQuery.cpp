@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSearchQuery.h"
+#include "OnlineSessionSettings.h"
+#include "SessionResultStore.h"
+#include "Async/ParallelFor.h"
+
+void FSessionSearchQuery::ApplyTo(FOnlineSessionSearch& _Search) const
+{
+    _Search.MaxSearchResults = MaxSearchResults;
+    _Search.bIsLanQuery = bIsLanQuery;
+    _Search.QuerySettings.Set(SEARCH_PRESENCE, bSearchPresence, EOnlineComparisonOp::Equals);
+
+    if(!MatchType.IsEmpty())
+    {
+        _Search.QuerySettings.Set(FName("MatchType"), MatchType, EOnlineComparisonOp::Equals);
+    }
+    if(MinOpenSlots > 0)
+    {
+        _Search.QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, MinOpenSlots, EOnlineComparisonOp::GreaterThanEquals);
+    }
+}
+
+bool FSessionSearchQuery::IsAcceptable(const FOnlineSessionSearchResult& _Result) const
+{
+    if(MinOpenSlots > 0 && _Result.Session.NumOpenPublicConnections < MinOpenSlots)
+    {
+        return false;
+    }
+    if(BuildUniqueId != 0 && _Result.Session.SessionSettings.BuildUniqueId != BuildUniqueId)
+    {
+        return false;
+    }
+    if(MaxPingInMs > 0 && _Result.PingInMs > MaxPingInMs)
+    {
+        return false;
+    }
+    if(!MatchType.IsEmpty())
+    {
+        FString SessionFound_MatchType;
+        _Result.Session.SessionSettings.Get(FName("MatchType"), SessionFound_MatchType); // MatchType is an OutParameter
+        if(SessionFound_MatchType != MatchType)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FSessionSearchQuery::Filter(TArray<FOnlineSessionSearchResult>& _Results, FSessionResultColumns& _Columns) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FSessionSearchQuery::Filter);
+    check(_Columns.Num() == _Results.Num());
+
+    const uint32 MatchTypeHash = FSessionResultColumns::HashMatchType(MatchType);
+
+    // One byte per row, so the workers never write to the same word
+    TArray<bool> Accepted;
+    Accepted.SetNumUninitialized(_Results.Num());
+    ParallelFor(TEXT("SessionSearchQuery.Filter"), _Results.Num(), 1024, [this, &_Results, &_Columns, &Accepted, MatchTypeHash](int32 Index)
+    {
+        if((MinOpenSlots > 0 && _Columns.OpenSlots[Index] < MinOpenSlots)
+            || (BuildUniqueId != 0 && _Columns.BuildUniqueId[Index] != BuildUniqueId)
+            || (MaxPingInMs > 0 && _Columns.PingInMs[Index] > MaxPingInMs)
+            || (!MatchType.IsEmpty() && _Columns.MatchTypeHash[Index] != MatchTypeHash))
+        {
+            Accepted[Index] = false;
+            return;
+        }
+        // Same hash, compare the strings in case of a collision
+        Accepted[Index] = MatchType.IsEmpty() || IsAcceptable(_Results[Index]);
+    });
+
+    int32 NumAccepted = 0;
+    for(int32 Index = 0; Index < _Results.Num(); ++Index)
+    {
+        if(!Accepted[Index])
+        {
+            continue;
+        }
+        if(NumAccepted != Index)
+        {
+            _Results[NumAccepted] = MoveTemp(_Results[Index]);
+            _Columns.MoveRow(Index, NumAccepted);
+        }
+        ++NumAccepted;
+    }
+    _Results.SetNum(NumAccepted);
+    _Columns.SetNum(NumAccepted);
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSettingsProfiles.h"
+#include "MultiplayerSessionsSettings.h"
+#include "MultiplayerSessionsLog.h"
+#include "OnlineSessionSettings.h"
+
+void FSessionSettingsProfiles::Build(const UMultiplayerSessionsSettings& _Settings, bool _bIsLANMatch, bool _bIsDedicated)
+{
+    bIsLANMatch = _bIsLANMatch;
+    bIsDedicated = _bIsDedicated;
+    BeaconPort = _Settings.bReserveSlotBeforeJoin ? _Settings.ReservationBeaconPort : 0;
+    Templates.Empty(_Settings.SessionProfiles.Num());
+
+    for(const FSessionSettingsProfile& Profile : _Settings.SessionProfiles)
+    {
+        if(Profile.MatchType.IsEmpty())
+        {
+            UE_LOG(LogMultiplayerSessions, Warning, TEXT("Session profile without MatchType skipped."));
+            continue;
+        }
+        if(Templates.Contains(Profile.MatchType))
+        {
+            UE_LOG(LogMultiplayerSessions, Warning, TEXT("Duplicate session profile '%s' skipped, the first one is used."), *Profile.MatchType);
+            continue;
+        }
+        Templates.Add(Profile.MatchType, MakeTemplate(Profile, Profile.MatchType));
+    }
+
+    DefaultTemplate = MakeTemplate(_Settings.DefaultSessionProfile, FString());
+    UE_LOG(LogMultiplayerSessions, Log, TEXT("%d session profiles built."), Templates.Num());
+}
+
+FSessionSettingsProfiles::FTemplate FSessionSettingsProfiles::MakeTemplate(const FSessionSettingsProfile& _Profile, const FString& _MatchType) const
+{
+    TSharedRef<FOnlineSessionSettings> SessionSettings = MakeShared<FOnlineSessionSettings>();
+    SessionSettings->bIsLANMatch = bIsLANMatch;
+    SessionSettings->NumPublicConnections = FMath::Max(_Profile.NumPublicConnections, 0);
+    SessionSettings->bAllowJoinInProgress = _Profile.bAllowJoinInProgress; // Allow players to join even if the session started
+    SessionSettings->bAllowJoinViaPresence = _Profile.bAllowJoinViaPresence; // Allows Steam to let players of the closest region join the server
+    SessionSettings->bShouldAdvertise = _Profile.bShouldAdvertise; // Allows Steam to advertise the session
+    SessionSettings->bUsesPresence = _Profile.bUsesPresence; // Allows Steam to search players which belongs to the region of the server in priority
+    SessionSettings->bUseLobbiesIfAvailable = _Profile.bUseLobbiesIfAvailable;
+    SessionSettings->BuildUniqueId = _Profile.BuildUniqueId; // Allow to find other hosted sessions
+    if(bIsDedicated)
+    {
+        // Presence and lobbies belong to a user, a dedicated server advertises itself as a game server
+        SessionSettings->bIsDedicated = true;
+        SessionSettings->bUsesPresence = false;
+        SessionSettings->bAllowJoinViaPresence = false;
+        SessionSettings->bUseLobbiesIfAvailable = false;
+    }
+    if(!_MatchType.IsEmpty())
+    {
+        SessionSettings->Set(FName("MatchType"), _MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+    }
+    if(BeaconPort > 0)
+    {
+        SessionSettings->Set(SETTING_BEACONPORT, BeaconPort, EOnlineDataAdvertisementType::ViaOnlineService);
+    }
+    return FTemplate{SessionSettings, _Profile.NumPublicConnections > 0};
+}
+
+TSharedRef<const FOnlineSessionSettings> FSessionSettingsProfiles::MakeSettings(const FString& _MatchType, int32 _NumPublicConnections) const
+{
+    if(const FTemplate* Template = Templates.Find(_MatchType))
+    {
+        if(Template->bFixedCapacity || Template->Settings->NumPublicConnections == _NumPublicConnections)
+        {
+            return Template->Settings;
+        }
+        TSharedRef<FOnlineSessionSettings> SessionSettings = MakeShared<FOnlineSessionSettings>(*Template->Settings);
+        SessionSettings->NumPublicConnections = _NumPublicConnections;
+        return SessionSettings;
+    }
+
+    // Build() not called yet: the defaults of the profile struct
+    const FTemplate& Default = DefaultTemplate.IsSet() ? DefaultTemplate.GetValue() : MakeTemplate(FSessionSettingsProfile(), FString());
+    TSharedRef<FOnlineSessionSettings> SessionSettings = MakeShared<FOnlineSessionSettings>(*Default.Settings);
+    if(!Default.bFixedCapacity)
+    {
+        SessionSettings->NumPublicConnections = _NumPublicConnections;
+    }
+    SessionSettings->Set(FName("MatchType"), _MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+    return SessionSettings;
+}
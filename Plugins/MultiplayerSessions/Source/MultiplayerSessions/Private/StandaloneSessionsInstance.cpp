@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StandaloneSessionsInstance.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "MultiplayerSessionsSubsystem.h"
+#include "OnlineSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+FStandaloneSessionsInstance::~FStandaloneSessionsInstance()
+{
+    Shutdown();
+}
+
+bool FStandaloneSessionsInstance::Init(const TCHAR* _Name)
+{
+    Name = _Name;
+    GameInstance = NewObject<UGameInstance>(GEngine);
+    GameInstance->AddToRoot();
+    GameInstance->InitializeStandalone(*Name);
+    Subsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+    return Subsystem != nullptr;
+}
+
+bool FStandaloneSessionsInstance::UseMockSession(const FMockOnlineSessionConfig& _MockConfig)
+{
+    if(!Subsystem)
+    {
+        return false;
+    }
+    MockSession = MakeShared<FMockOnlineSession, ESPMode::ThreadSafe>(_MockConfig);
+    return Subsystem->OverrideSessionInterface(MockSession);
+}
+
+bool FStandaloneSessionsInstance::UseNullSubsystem()
+{
+    if(!Subsystem)
+    {
+        return false;
+    }
+    NullInstanceName = *FString::Printf(TEXT("NULL:%s"), *Name);
+    IOnlineSubsystem* NullSubsystem = IOnlineSubsystem::Get(NullInstanceName);
+    return NullSubsystem && Subsystem->OverrideSessionInterface(NullSubsystem->GetSessionInterface(), true);
+}
+
+void FStandaloneSessionsInstance::Shutdown()
+{
+    if(!GameInstance)
+    {
+        return;
+    }
+    if(Subsystem)
+    {
+        Subsystem->OverrideSessionInterface(nullptr);
+    }
+
+    UWorld* World = GameInstance->GetWorld();
+    GameInstance->Shutdown();
+    if(World)
+    {
+        World->DestroyWorld(false);
+        GEngine->DestroyWorldContext(World);
+    }
+    GameInstance->RemoveFromRoot();
+    GameInstance = nullptr;
+    Subsystem = nullptr;
+    MockSession.Reset();
+
+    if(!NullInstanceName.IsNone())
+    {
+        IOnlineSubsystem::Destroy(NullInstanceName);
+        NullInstanceName = NAME_None;
+    }
+}
+
+#endif
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "MockOnlineSession.h"
+
+class UGameInstance;
+class UMultiplayerSessionsSubsystem;
+
+/**
+ * @brief Standalone game instance with its own subsystem, for the automation tests and the SessionLoad commandlet.
+ * The subsystem never talks to the real backend: it runs against a FMockOnlineSession, a NULL online subsystem of its own,
+ * or the session interface the caller overrides it with.
+ */
+struct FStandaloneSessionsInstance
+{
+	UGameInstance* GameInstance{nullptr};
+	UMultiplayerSessionsSubsystem* Subsystem{nullptr};
+	TSharedPtr<FMockOnlineSession, ESPMode::ThreadSafe> MockSession;
+
+	~FStandaloneSessionsInstance();
+
+	/**
+	 * @brief Create the game instance, its subsystem keeps the default session interface until one of the Use* calls.
+	 * @return false if the game instance has no subsystem.
+	 */
+	bool Init(const TCHAR* _Name);
+
+	/**
+	 * @return false if the subsystem refused the mock, e.g. because it is busy.
+	 */
+	bool UseMockSession(const FMockOnlineSessionConfig& _MockConfig);
+
+	/**
+	 * @brief Run against a NULL online subsystem named after the game instance, destroyed by Shutdown. Its sessions are LAN sessions.
+	 */
+	bool UseNullSubsystem();
+
+	void Shutdown();
+
+private:
+
+	FString Name;
+	FName NullInstanceName;
+};
+
+#endif
@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "StandaloneSessionsInstance.h"
+#include "SessionFlowBenchmark.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Misc/AutomationTest.h"
+
+/**
+ * The scenarios of MultiplayerSessions.Benchmark, with their outcome checked instead of only logged:
+ * how many sessions the searches return and how many operations fail for a failure rate of the mock.
+ */
+namespace
+{
+    using EOperation = FSessionFlowBenchmark::EOperation;
+
+    // Above the step timeout of the benchmark, which aborts it by itself
+    constexpr double BenchmarkTimeout = 120.0;
+
+    constexpr int32 SmallSearchIterations = 5;
+    constexpr int32 LargeSearchIterations = 3;
+    // Few enough searches to stay within the retry budget, retries would fail too and only slow the test down
+    constexpr int32 AllFailIterations = 4;
+    constexpr int32 FailureRateIterations = 30;
+    constexpr float FailureRate = 0.3f;
+
+    struct FBenchmarkTestState
+    {
+        FStandaloneSessionsInstance Instance;
+        double Deadline{0.0};
+        bool bFinished{false};
+    };
+
+    FSessionFlowBenchmark::FParams MakeParams(int32 _NumSearchResults, float _FailureRate, int32 _Iterations)
+    {
+        FSessionFlowBenchmark::FParams Params;
+        Params.Mock.NumSearchResults = _NumSearchResults;
+        Params.Mock.FailureRate = _FailureRate;
+        Params.Mock.Latency.Mean = 0.005f;
+        Params.Mock.MatchTypes = {Params.MatchType};
+        Params.Iterations = _Iterations;
+        return Params;
+    }
+
+    /**
+     * @brief Run the benchmark on a game instance of its own, _Check gets it once it is over.
+     * @return false if it could not start.
+     */
+    bool RunBenchmark(FAutomationTestBase& _Test, const TCHAR* _Name, FSessionFlowBenchmark::FParams&& _Params,
+        TFunction<void(const FSessionFlowBenchmark&)>&& _Check)
+    {
+        TSharedRef<FBenchmarkTestState> State = MakeShared<FBenchmarkTestState>();
+        if(!State->Instance.Init(_Name))
+        {
+            _Test.AddError(TEXT("Could not create a game instance with the sessions subsystem."));
+            return false;
+        }
+
+        // Weak, the benchmark may outlive a test which timed out
+        TWeakPtr<FBenchmarkTestState> WeakState = State;
+        _Params.OnFinished = [&_Test, WeakState, Check = MoveTemp(_Check)](const FSessionFlowBenchmark& Benchmark, bool bAborted)
+        {
+            TSharedPtr<FBenchmarkTestState> Finished = WeakState.Pin();
+            if(!Finished.IsValid())
+            {
+                return;
+            }
+            Finished->bFinished = true;
+            if(_Test.TestFalse(TEXT("The benchmark runs to the end"), bAborted))
+            {
+                Check(Benchmark);
+            }
+        };
+
+        if(!FSessionFlowBenchmark::Start(State->Instance.Subsystem, _Params))
+        {
+            _Test.AddError(TEXT("Could not start the benchmark, one is already running."));
+            return false;
+        }
+
+        State->Deadline = FPlatformTime::Seconds() + BenchmarkTimeout;
+        ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([&_Test, State]()
+        {
+            if(!State->bFinished && FPlatformTime::Seconds() < State->Deadline)
+            {
+                return false;
+            }
+            _Test.TestTrue(TEXT("The benchmark finishes in time"), State->bFinished);
+            State->Instance.Shutdown();
+            return true;
+        }));
+        return true;
+    }
+
+    /**
+     * @brief What each search of the benchmark must return: the sessions of the mock the query accepts, within MaxSearchResults.
+     */
+    int32 GetExpectedSearchResults(const FSessionFlowBenchmark& _Benchmark)
+    {
+        const FSessionSearchQuery Query = _Benchmark.GetSearchQuery();
+        const TArray<FOnlineSessionSearchResult>& MockResults = _Benchmark.GetMockSession().GetSearchResults();
+        const int32 NumReturned = FMath::Min(MockResults.Num(), Query.MaxSearchResults);
+
+        int32 NumAcceptable = 0;
+        for(int32 Index = 0; Index < NumReturned; ++Index)
+        {
+            NumAcceptable += Query.IsAcceptable(MockResults[Index]) ? 1 : 0;
+        }
+        return NumAcceptable;
+    }
+
+    void TestNoFailure(FAutomationTestBase& _Test, const FSessionFlowBenchmark& _Benchmark, int32 _Iterations)
+    {
+        _Test.TestEqual(TEXT("Every host creates its session"), _Benchmark.GetNumSucceeded(EOperation::Create), _Iterations);
+        _Test.TestEqual(TEXT("Every client finds sessions"), _Benchmark.GetNumSucceeded(EOperation::Find), _Iterations);
+        _Test.TestEqual(TEXT("Every client joins"), _Benchmark.GetNumSucceeded(EOperation::Join), _Iterations);
+        _Test.TestEqual(TEXT("Every client flow completes"), _Benchmark.GetNumSucceeded(EOperation::ClientFlow), _Iterations);
+        for(const EOperation Operation : {EOperation::Create, EOperation::Destroy, EOperation::Find, EOperation::Join, EOperation::ClientFlow})
+        {
+            _Test.TestEqual(TEXT("No operation fails"), _Benchmark.GetNumFailed(Operation), 0);
+        }
+    }
+
+    void TestSearchResults(FAutomationTestBase& _Test, const FSessionFlowBenchmark& _Benchmark)
+    {
+        const int32 Expected = GetExpectedSearchResults(_Benchmark);
+        _Test.TestTrue(TEXT("The mock has sessions the query accepts"), Expected > 0);
+        for(const int32 NumResults : _Benchmark.GetSearchResultCounts())
+        {
+            _Test.TestEqual(TEXT("Each search returns every session of the mock the query accepts"), NumResults, Expected);
+        }
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionFlowBenchmarkSmallSearchTest, "MultiplayerSessions.Benchmark.SmallSearch",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * @brief Results=100: the results are processed on the game thread. Nothing fails, every search returns the same sessions.
+ */
+bool FSessionFlowBenchmarkSmallSearchTest::RunTest(const FString& Parameters)
+{
+    return RunBenchmark(*this, TEXT("SessionFlowBenchmarkSmallSearch"), MakeParams(100, 0.f, SmallSearchIterations), [this](const FSessionFlowBenchmark& Benchmark)
+    {
+        TestNoFailure(*this, Benchmark, SmallSearchIterations);
+        TestSearchResults(*this, Benchmark);
+    });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionFlowBenchmarkLargeSearchTest, "MultiplayerSessions.Benchmark.LargeSearch",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * @brief Results=100000: the results are processed on worker threads and capped by MaxSearchResults.
+ */
+bool FSessionFlowBenchmarkLargeSearchTest::RunTest(const FString& Parameters)
+{
+    return RunBenchmark(*this, TEXT("SessionFlowBenchmarkLargeSearch"), MakeParams(100000, 0.f, LargeSearchIterations), [this](const FSessionFlowBenchmark& Benchmark)
+    {
+        TestNoFailure(*this, Benchmark, LargeSearchIterations);
+        TestSearchResults(*this, Benchmark);
+    });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionFlowBenchmarkAllFailTest, "MultiplayerSessions.Benchmark.AllFail",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * @brief FailureRate=1: every call to the backend fails, and each failure is reported once, nothing is left hanging.
+ */
+bool FSessionFlowBenchmarkAllFailTest::RunTest(const FString& Parameters)
+{
+    return RunBenchmark(*this, TEXT("SessionFlowBenchmarkAllFail"), MakeParams(100, 1.f, AllFailIterations), [this](const FSessionFlowBenchmark& Benchmark)
+    {
+        for(const EOperation Operation : {EOperation::Create, EOperation::Find, EOperation::Join, EOperation::ClientFlow})
+        {
+            TestEqual(TEXT("The operation fails every time"), Benchmark.GetNumFailed(Operation), AllFailIterations);
+            TestEqual(TEXT("The operation never succeeds"), Benchmark.GetNumSucceeded(Operation), 0);
+        }
+        // Nothing was created or joined
+        TestEqual(TEXT("No session is destroyed"), Benchmark.GetNumSucceeded(EOperation::Destroy) + Benchmark.GetNumFailed(EOperation::Destroy), 0);
+        TestEqual(TEXT("No search returns sessions"), Benchmark.GetSearchResultCounts().Num(), 0);
+    });
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionFlowBenchmarkFailureRateTest, "MultiplayerSessions.Benchmark.FailureRate",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * @brief FailureRate=0.3: every operation ends once, as a success or a failure. The host flow fails about as often as the mock,
+ * the searches less often than the calls to the mock since the failed ones are retried, and those which succeed return the same
+ * sessions as without failures.
+ */
+bool FSessionFlowBenchmarkFailureRateTest::RunTest(const FString& Parameters)
+{
+    return RunBenchmark(*this, TEXT("SessionFlowBenchmarkFailureRate"), MakeParams(100, FailureRate, FailureRateIterations), [this](const FSessionFlowBenchmark& Benchmark)
+    {
+        for(const EOperation Operation : {EOperation::Create, EOperation::Find, EOperation::Join, EOperation::ClientFlow})
+        {
+            TestEqual(TEXT("Every iteration ends the operation once"), Benchmark.GetNumSucceeded(Operation) + Benchmark.GetNumFailed(Operation), FailureRateIterations);
+        }
+
+        // The seed is fixed, the bounds are those of the binomial distribution (about 3 standard deviations)
+        const int32 NumCreateFailures = Benchmark.GetNumFailed(EOperation::Create);
+        TestTrue(FString::Printf(TEXT("The host flow fails about %.0f%% of the time (%d of %d)"), FailureRate * 100.f, NumCreateFailures, FailureRateIterations),
+            NumCreateFailures >= 2 && NumCreateFailures <= 17);
+
+        // Each failed call to the mock is either retried or fails the search, so fewer failed searches means some were retried and succeeded
+        const int32 NumFindFailures = Benchmark.GetNumFailed(EOperation::Find);
+        const int32 NumBackendFindFailures = Benchmark.GetNumBackendFindFailures();
+        TestTrue(TEXT("The mock fails some searches"), NumBackendFindFailures > 0);
+        TestTrue(FString::Printf(TEXT("Retries make the searches fail less often than the backend (%d of %d)"), NumFindFailures, NumBackendFindFailures),
+            NumFindFailures < NumBackendFindFailures);
+
+        TestTrue(TEXT("Some client flows complete"), Benchmark.GetNumSucceeded(EOperation::ClientFlow) > 0);
+        TestTrue(TEXT("Some client flows fail"), Benchmark.GetNumFailed(EOperation::ClientFlow) > 0);
+
+        TestEqual(TEXT("Every search that succeeded returned sessions"), Benchmark.GetSearchResultCounts().Num(), Benchmark.GetNumSucceeded(EOperation::Find));
+        TestSearchResults(*this, Benchmark);
+    });
+}
+
+#endif
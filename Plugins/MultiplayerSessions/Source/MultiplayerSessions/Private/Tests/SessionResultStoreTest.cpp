@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "StandaloneSessionsInstance.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "SessionResultStore.h"
+#include "SessionSearchQuery.h"
+#include "Misc/AutomationTest.h"
+
+namespace
+{
+    // The mock answers in a few ms, the search is stuck past that
+    constexpr double OperationTimeout = 10.0;
+    constexpr int32 NumListeners = 4;
+    constexpr int32 NumSearchResults = 500; // Above AsyncResultProcessingThreshold, the store is built on a worker
+
+    struct FSharedStoreTestState
+    {
+        FStandaloneSessionsInstance Instance;
+        uint32 NumCreatedBefore{0};
+        double Deadline{0.0};
+
+        TArray<FSessionResultStorePtr> ListenerStores;
+        int32 NumBroadcasts{0};
+        bool bSearchSucceeded{false};
+
+        FSessionResultHandle JoinHandle;
+        TOptional<EOnJoinSessionCompleteResult::Type> JoinResult;
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSessionResultStoreSharedTest, "MultiplayerSessions.ResultStore.OneStorePerSearch",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * @brief One search with several listeners allocates one store, which every listener gets and which the join handle points into.
+ */
+bool FSessionResultStoreSharedTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FSharedStoreTestState> State = MakeShared<FSharedStoreTestState>();
+
+    FMockOnlineSessionConfig MockConfig;
+    MockConfig.NumSearchResults = NumSearchResults;
+    MockConfig.Latency.Mean = 0.01f;
+    if(!State->Instance.Init(TEXT("SessionResultStoreTest")) || !State->Instance.UseMockSession(MockConfig))
+    {
+        AddError(TEXT("Could not create a game instance running against the mock session interface."));
+        return false;
+    }
+    UMultiplayerSessionsSubsystem* Subsystem = State->Instance.Subsystem;
+    Subsystem->FlushSearchCache();
+
+    // Weak, the state owns the subsystem which owns the delegates
+    TWeakPtr<FSharedStoreTestState> WeakState = State;
+    for(int32 ListenerIndex = 0; ListenerIndex < NumListeners; ++ListenerIndex)
+    {
+        Subsystem->CustomOnFindSessionsCompleteDelegate.AddLambda([WeakState](const FSessionSearchQuery& SearchQuery, const FSessionResultStorePtr& SessionResults, bool bWasSuccessful)
+        {
+            if(TSharedPtr<FSharedStoreTestState> Listener = WeakState.Pin())
+            {
+                Listener->ListenerStores.Add(SessionResults);
+                Listener->bSearchSucceeded = bWasSuccessful;
+                ++Listener->NumBroadcasts;
+            }
+        });
+    }
+    Subsystem->CustomOnJoinSessionCompleteDelegate.AddLambda([WeakState](EOnJoinSessionCompleteResult::Type Result)
+    {
+        if(TSharedPtr<FSharedStoreTestState> Listener = WeakState.Pin())
+        {
+            Listener->JoinResult = Result;
+        }
+    });
+
+    FSessionSearchQuery Query;
+    Query.MinOpenSlots = 1;
+
+    // Everything the search allocates counts, the store built on a worker thread too
+    State->NumCreatedBefore = FSessionResultStore::GetNumCreated();
+    State->Deadline = FPlatformTime::Seconds() + OperationTimeout;
+    Subsystem->FindSessions(Query);
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]()
+    {
+        if(State->NumBroadcasts < NumListeners && FPlatformTime::Seconds() < State->Deadline)
+        {
+            return false;
+        }
+
+        TestEqual(TEXT("Every listener is called once"), State->NumBroadcasts, NumListeners);
+        TestTrue(TEXT("The search succeeds"), State->bSearchSucceeded);
+        TestEqual(TEXT("One store per search, whatever the number of listeners and results"), static_cast<int32>(FSessionResultStore::GetNumCreated() - State->NumCreatedBefore), 1);
+
+        const FSessionResultStorePtr Store = State->ListenerStores.IsEmpty() ? nullptr : State->ListenerStores[0];
+        if(!TestTrue(TEXT("The search found sessions"), Store.IsValid() && Store->Num() > 0))
+        {
+            State->Instance.Shutdown();
+            return true;
+        }
+        for(const FSessionResultStorePtr& ListenerStore : State->ListenerStores)
+        {
+            TestTrue(TEXT("Every listener gets the same store"), ListenerStore == Store);
+        }
+        TestTrue(TEXT("The subsystem keeps that store"), State->Instance.Subsystem->GetSessionResults() == Store);
+
+        State->JoinHandle = Store->MakeHandle(0);
+        TestTrue(TEXT("The join handle points to the store"), State->JoinHandle.GetStore() == Store);
+        TestTrue(TEXT("The join handle points to the result in the store, not to a copy"), State->JoinHandle.Get() == &Store->GetResults()[0]);
+
+        State->Deadline = FPlatformTime::Seconds() + OperationTimeout;
+        State->Instance.Subsystem->JoinSession(State->JoinHandle);
+        return true;
+    }));
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]()
+    {
+        if(State->JoinHandle.IsValid() && !State->JoinResult.IsSet() && FPlatformTime::Seconds() < State->Deadline)
+        {
+            return false;
+        }
+
+        if(State->JoinHandle.IsValid())
+        {
+            TestTrue(TEXT("The session of the handle is joined"), State->JoinResult.IsSet() && State->JoinResult.GetValue() == EOnJoinSessionCompleteResult::Success);
+            TestEqual(TEXT("Joining doesn't build another store"), static_cast<int32>(FSessionResultStore::GetNumCreated() - State->NumCreatedBefore), 1);
+        }
+        State->Instance.Shutdown();
+        return true;
+    }));
+
+    return true;
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include "W_Menu.h"
 #include "Components/Button.h"
 #include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionsLog.h"
+#include "MultiplayerSessionsSettings.h"
 #include "OnlineSessionSettings.h" 
 #include "OnlineSubsystem.h"
 #include "Interfaces/OnlineSessionInterface.h"
@@ -30,6 +32,11 @@ bool UW_Menu::Initialize()
         JoinButton->OnClicked.AddDynamic(this, &ThisClass::JoinButtonClicked);
     }
 
+    if(QuickMatchButton)
+    {
+        QuickMatchButton->OnClicked.AddDynamic(this, &ThisClass::QuickMatchButtonClicked);
+    }
+
     return true;
 }
 
@@ -79,6 +86,12 @@ void UW_Menu::MenuSetup(int32 _NumPublicConnections, FString _MatchType, FString
         // For t
         MultiplayerSessionsSubsystem->CustomOnFindSessionsCompleteDelegate.AddUObject(this, &ThisClass::OnFindSessions);
         MultiplayerSessionsSubsystem->CustomOnJoinSessionCompleteDelegate.AddUObject(this, &ThisClass::OnJoinSession);
+        MultiplayerSessionsSubsystem->CustomOnQuickMatchCompleteDelegate.AddUObject(this, &ThisClass::OnQuickMatch);
+
+        if(GetDefault<UMultiplayerSessionsSettings>()->bPrefetchSessions)
+        {
+            MultiplayerSessionsSubsystem->StartPrefetch(MakeJoinQuery());
+        }
     }
 }
 
@@ -91,7 +104,7 @@ void UW_Menu::HostButtonClicked()
     if(!MultiplayerSessionsSubsystem)
     {
         HostButton->SetIsEnabled(true);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("MultiplayerSessionsSubsystem plugin is Invalid.")));}
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no MultiplayerSessionsSubsystem."));
 		return;    
     }
     MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType);
@@ -106,102 +119,163 @@ void UW_Menu::JoinButtonClicked()
     if(!MultiplayerSessionsSubsystem)
     {
         JoinButton->SetIsEnabled(true);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("MultiplayerSessionsSubsystem plugin is Invalid.")));}
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no MultiplayerSessionsSubsystem."));
 		return;    
     }
-    
-    MultiplayerSessionsSubsystem->FindSessions(10000);
+
+    MultiplayerSessionsSubsystem->FindSessions(MakeJoinQuery());
+}
+
+FSessionSearchQuery UW_Menu::MakeJoinQuery() const
+{
+    FSessionSearchQuery Query;
+    Query.MatchType = MatchType;
+    Query.MinOpenSlots = 1;
+    // The subsystem knows which online subsystem it runs on, the host settings are built from the same flag
+    Query.bIsLanQuery = MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->IsLANSubsystem();
+    Query.MaxSearchResults = 10000;
+    return Query;
 }
 
+/**
+ * @brief Quick match button. Joins a session if one is found in time, hosts one otherwise.
+ */
+void UW_Menu::QuickMatchButtonClicked()
+{
+    SetButtonsEnabled(false);
+    if(!MultiplayerSessionsSubsystem)
+    {
+        SetButtonsEnabled(true);
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no MultiplayerSessionsSubsystem."));
+		return;
+    }
+
+    MultiplayerSessionsSubsystem->QuickMatch(MatchType, QuickMatchBudget, NumPublicConnections, PathToLobby);
+}
+
+void UW_Menu::SetButtonsEnabled(bool bEnabled)
+{
+    HostButton->SetIsEnabled(bEnabled);
+    JoinButton->SetIsEnabled(bEnabled);
+    if(QuickMatchButton)
+    {
+        QuickMatchButton->SetIsEnabled(bEnabled);
+    }
+}
+
+void UW_Menu::OnQuickMatch(EQuickMatchResult Result)
+{
+    // The subsystem travels by itself when the quick match succeeds
+    if(Result == EQuickMatchResult::Failed)
+    {
+        SetButtonsEnabled(true);
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("Menu: quick match failed."));
+    }
+}
 
 void UW_Menu::OnCreateSession(bool bWasSuccessful)
 {
+    // The quick match travels by itself
+    if(MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->IsQuickMatchInProgress())
+    {
+        return;
+    }
+
     if(bWasSuccessful)
     {
         UWorld* World = GetWorld();
         if(World)
-        {   
+        {
+            // Hard travel on purpose: only a full load of the lobby opens the listen server. The lobby travels seamlessly from there.
             if(World->ServerTravel(PathToLobby))
             {
-                if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Green, FString::Printf(TEXT("In the lobby")));}
+                UE_LOG(LogMultiplayerSessions, Log, TEXT("Menu: session created, travelling to the lobby."));
+                return;
             }
             else
             {
                 JoinButton->SetIsEnabled(true);
-                if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Impossible to travel to the lobby")));}
+                UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: ServerTravel to %s failed."), *PathToLobby);
                 return;
             }
         }
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Impossible to get the world")));}
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no world to travel from."));
         JoinButton->SetIsEnabled(true);
     }
     else
     {
         JoinButton->SetIsEnabled(true);
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Failed to create the session")));}
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("Menu: failed to create the session."));
         return;    
     }
 
 }
 
-void UW_Menu::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResult, bool bWasSuccessful)
+void UW_Menu::OnFindSessions(const FSessionSearchQuery& Query, const FSessionResultStorePtr& SessionResults, bool bWasSuccessful)
 {
     if(!MultiplayerSessionsSubsystem)
 	{
         JoinButton->SetIsEnabled(true);
-		if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Custom MultiplayerSessionsSubsystem plugin is invalid.")));}
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no MultiplayerSessionsSubsystem."));
 		return;
 	}
 
-	if(bWasSuccessful)
+    // The quick match joins by itself
+    if(MultiplayerSessionsSubsystem->IsQuickMatchInProgress())
+    {
+        return;
+    }
+
+	if(bWasSuccessful && SessionResults.IsValid())
 	{
-		FString SessionFound_MatchType;
-		for(auto Result : SessionResult)
-		{
-			Result.Session.SessionSettings.Get(FName("MatchType"), SessionFound_MatchType); // MatchType is an OutParameter
-			if (SessionFound_MatchType == MatchType)
-			{
-				MultiplayerSessionsSubsystem->JoinSession(Result);
-                return;
-			}
-		}
+        // Not the first session of our MatchType, the best one for us (ping, free slots...)
+        if(MultiplayerSessionsSubsystem->JoinBestSession(SessionResults, MatchType))
+        {
+            return;
+        }
         JoinButton->SetIsEnabled(true);
 
 	}
 	else
 	{
         JoinButton->SetIsEnabled(true);
-		if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("No sessions found.")));}
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Menu: no session found."));
 	}
 }
 
 void UW_Menu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 {
-    IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
-    if(Subsystem && Result == EOnJoinSessionCompleteResult::Success)
+    // The quick match travels by itself
+    if(MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->IsQuickMatchInProgress())
+    {
+        return;
+    }
+
+    if(MultiplayerSessionsSubsystem && Result == EOnJoinSessionCompleteResult::Success)
     {
-        IOnlineSessionPtr SessionInterface = Subsystem->GetSessionInterface();
         APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
         FString Address;
 
-        if(SessionInterface->GetResolvedConnectString(NAME_GameSession, Address) && PlayerController && SessionInterface)
+        // Usually resolved by the subsystem when the search completed, host name lookup included
+        if(PlayerController && MultiplayerSessionsSubsystem->GetResolvedConnectString(Address))
         {
+            // Connecting to the host needs an absolute travel, the lobby and the host's later travels are seamless
             PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
-            if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Green, FString::Printf(TEXT("URL Connection : %s."), *Address));}
+            UE_LOG(LogMultiplayerSessions, Log, TEXT("Menu: travelling to %s."), *Address);
             return;
         }
         else 
         {
-            if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Impossible to join the session.")));}
+            UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no connect string for the joined session."));
         }
     }
-    else if(!Subsystem)
+    else if(!MultiplayerSessionsSubsystem)
     {
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Impossible to get the IOnlineSubsystem")));}
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("Menu: no MultiplayerSessionsSubsystem."));
     } 
-    else if(!Result == EOnJoinSessionCompleteResult::Success)
+    else
     {
-        if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, FString::Printf(TEXT("Impossible to join the session : %s"), EOnJoinSessionCompleteResult::Success));}
+        UE_LOG(LogMultiplayerSessions, Warning, TEXT("Menu: failed to join the session (%s)."), LexToString(Result));
     }
     
     JoinButton->SetIsEnabled(true);
@@ -235,6 +309,10 @@ void UW_Menu::NativeDestruct()
  */
 void UW_Menu::MenuTearDown()
 {
+    if(MultiplayerSessionsSubsystem)
+    {
+        MultiplayerSessionsSubsystem->StopPrefetch();
+    }
     RemoveFromParent();
         UWorld* World = GetWorld();
         if(World)
@@ -0,0 +1,327 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "W_SessionBrowser.h"
+#include "W_SessionBrowserEntry.h"
+#include "Components/Button.h"
+#include "Components/EditableTextBox.h"
+#include "Components/ListView.h"
+#include "MultiplayerSessionsLog.h"
+#include "SessionSearchQuery.h"
+#include "GameFramework/PlayerController.h"
+#include "Algo/Sort.h"
+
+bool UW_SessionBrowser::Initialize()
+{
+    if(!Super::Initialize())
+    {
+        return false;
+    }
+
+    if(RefreshButton)
+    {
+        RefreshButton->OnClicked.AddDynamic(this, &ThisClass::RefreshButtonClicked);
+    }
+
+    if(JoinButton)
+    {
+        JoinButton->OnClicked.AddDynamic(this, &ThisClass::JoinButtonClicked);
+    }
+
+    if(NameFilterBox)
+    {
+        NameFilterBox->OnTextChanged.AddDynamic(this, &ThisClass::NameFilterChanged);
+    }
+
+    return true;
+}
+
+void UW_SessionBrowser::BrowserSetup(FString _MatchType)
+{
+    MatchType = _MatchType;
+
+    UGameInstance* GameInstance = GetGameInstance();
+    if(GameInstance)
+    {
+        MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+    }
+
+    if(!MultiplayerSessionsSubsystem)
+    {
+        UE_LOG(LogMultiplayerSessions, Error, TEXT("Session browser: no MultiplayerSessionsSubsystem."));
+        return;
+    }
+    MultiplayerSessionsSubsystem->CustomOnFindSessionsCompleteDelegate.AddUObject(this, &ThisClass::OnFindSessions);
+    MultiplayerSessionsSubsystem->CustomOnSessionSearchCacheUpdatedDelegate.AddUObject(this, &ThisClass::OnSearchCacheUpdated);
+    MultiplayerSessionsSubsystem->CustomOnJoinSessionCompleteDelegate.AddUObject(this, &ThisClass::OnJoinSession);
+
+    Refresh();
+}
+
+void UW_SessionBrowser::Refresh()
+{
+    if(!MultiplayerSessionsSubsystem)
+    {
+        return;
+    }
+
+    if(RefreshButton)
+    {
+        RefreshButton->SetIsEnabled(false);
+    }
+
+    SearchQuery = FSessionSearchQuery();
+    SearchQuery.MatchType = MatchType;
+    SearchQuery.bIsLanQuery = MultiplayerSessionsSubsystem->IsLANSubsystem();
+    SearchQuery.MaxSearchResults = MaxSearchResults;
+
+    // May be answered right away from the search cache
+    MultiplayerSessionsSubsystem->FindSessions(SearchQuery);
+}
+
+void UW_SessionBrowser::OnFindSessions(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults, bool bWasSuccessful)
+{
+    // A quick match would replace the list with its first result
+    if(_Query != SearchQuery)
+    {
+        return;
+    }
+
+    if(RefreshButton)
+    {
+        RefreshButton->SetIsEnabled(true);
+    }
+    if(!bWasSuccessful)
+    {
+        UE_LOG(LogMultiplayerSessions, Log, TEXT("Session browser: the search failed."));
+    }
+    StartPopulating(_SessionResults);
+}
+
+void UW_SessionBrowser::OnSearchCacheUpdated(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults)
+{
+    if(_Query != SearchQuery)
+    {
+        return;
+    }
+    StartPopulating(_SessionResults);
+}
+
+/**
+ * @brief Empty the list, the results are added over the next frames.
+ */
+void UW_SessionBrowser::StartPopulating(const FSessionResultStorePtr& _SessionResults)
+{
+    SessionResults = _SessionResults;
+    NumPopulated = 0;
+
+    // Pooled items past the new results must not keep the old results alive
+    const int32 NumResults = SessionResults.IsValid() ? SessionResults->Num() : 0;
+    for(int32 Index = NumResults; Index < ItemPool.Num(); ++Index)
+    {
+        ItemPool[Index]->Fill(FSessionResultHandle());
+    }
+    VisibleItems.Reset();
+    SessionList->SetListItems(VisibleItems);
+    PopulateNextItems();
+}
+
+void UW_SessionBrowser::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+{
+    Super::NativeTick(MyGeometry, InDeltaTime);
+
+    if(SessionResults.IsValid() && NumPopulated < SessionResults->Num())
+    {
+        PopulateNextItems();
+    }
+}
+
+/**
+ * @brief Fill the items of the next ItemsPerFrame results, then merge the ones that pass the filter into the sorted list.
+ */
+void UW_SessionBrowser::PopulateNextItems()
+{
+    if(!SessionResults.IsValid())
+    {
+        return;
+    }
+
+    const int32 EndIndex = FMath::Min(NumPopulated + ItemsPerFrame, SessionResults->Num());
+    NewItems.Reset();
+    for(int32 Index = NumPopulated; Index < EndIndex; ++Index)
+    {
+        if(!ItemPool.IsValidIndex(Index))
+        {
+            ItemPool.Add(NewObject<USessionBrowserItem>(this));
+        }
+        USessionBrowserItem* Item = ItemPool[Index];
+        Item->Fill(SessionResults->MakeHandle(Index));
+        if(PassesFilter(*Item))
+        {
+            NewItems.Add(Item);
+        }
+    }
+    NumPopulated = EndIndex;
+    if(NewItems.IsEmpty())
+    {
+        return;
+    }
+
+    NewItems.Sort([this](const USessionBrowserItem& A, const USessionBrowserItem& B) { return IsBefore(A, B); });
+
+    // Linear merge, the list is already sorted
+    MergedItems.Reset(VisibleItems.Num() + NewItems.Num());
+    int32 VisibleIndex = 0;
+    int32 NewIndex = 0;
+    while(VisibleIndex < VisibleItems.Num() && NewIndex < NewItems.Num())
+    {
+        const USessionBrowserItem* VisibleItem = CastChecked<USessionBrowserItem>(VisibleItems[VisibleIndex]);
+        if(IsBefore(*NewItems[NewIndex], *VisibleItem))
+        {
+            MergedItems.Add(NewItems[NewIndex++]);
+        }
+        else
+        {
+            MergedItems.Add(VisibleItems[VisibleIndex++]);
+        }
+    }
+    MergedItems.Append(VisibleItems.GetData() + VisibleIndex, VisibleItems.Num() - VisibleIndex);
+    for(; NewIndex < NewItems.Num(); ++NewIndex)
+    {
+        MergedItems.Add(NewItems[NewIndex]);
+    }
+    Swap(VisibleItems, MergedItems);
+
+    // Only the rows on screen are refreshed
+    SessionList->SetListItems(VisibleItems);
+}
+
+bool UW_SessionBrowser::PassesFilter(const USessionBrowserItem& _Item) const
+{
+    if(bHideFull && _Item.OpenSlots <= 0)
+    {
+        return false;
+    }
+    return NameFilter.IsEmpty() || _Item.OwningUserName.Contains(NameFilter);
+}
+
+bool UW_SessionBrowser::IsBefore(const USessionBrowserItem& _A, const USessionBrowserItem& _B) const
+{
+    const USessionBrowserItem& First = bSortAscending ? _A : _B;
+    const USessionBrowserItem& Second = bSortAscending ? _B : _A;
+    switch(SortBy)
+    {
+    case ESessionBrowserSort::OpenSlots:        return First.OpenSlots < Second.OpenSlots;
+    case ESessionBrowserSort::OwningUserName:   return First.OwningUserName.Compare(Second.OwningUserName, ESearchCase::IgnoreCase) < 0;
+    case ESessionBrowserSort::MatchType:        return First.MatchType.Compare(Second.MatchType, ESearchCase::IgnoreCase) < 0;
+    default:                                    return First.PingInMs < Second.PingInMs;
+    }
+}
+
+void UW_SessionBrowser::SetSort(ESessionBrowserSort _SortBy, bool _bAscending)
+{
+    SortBy = _SortBy;
+    bSortAscending = _bAscending;
+    ApplySortAndFilter();
+}
+
+void UW_SessionBrowser::SetFilter(const FString& _NameFilter, bool _bHideFull)
+{
+    NameFilter = _NameFilter;
+    bHideFull = _bHideFull;
+    ApplySortAndFilter();
+}
+
+void UW_SessionBrowser::NameFilterChanged(const FText& Text)
+{
+    SetFilter(Text.ToString(), bHideFull);
+}
+
+void UW_SessionBrowser::ApplySortAndFilter()
+{
+    VisibleItems.Reset();
+    for(int32 Index = 0; Index < NumPopulated; ++Index)
+    {
+        if(PassesFilter(*ItemPool[Index]))
+        {
+            VisibleItems.Add(ItemPool[Index]);
+        }
+    }
+    Algo::Sort(VisibleItems, [this](const TObjectPtr<UObject>& A, const TObjectPtr<UObject>& B)
+    {
+        return IsBefore(*CastChecked<USessionBrowserItem>(A), *CastChecked<USessionBrowserItem>(B));
+    });
+    SessionList->SetListItems(VisibleItems);
+}
+
+void UW_SessionBrowser::RefreshButtonClicked()
+{
+    Refresh();
+}
+
+void UW_SessionBrowser::JoinButtonClicked()
+{
+    JoinSelected();
+}
+
+void UW_SessionBrowser::JoinSelected()
+{
+    const USessionBrowserItem* Item = SessionList->GetSelectedItem<USessionBrowserItem>();
+    if(!MultiplayerSessionsSubsystem || !Item || !Item->GetHandle().IsValid())
+    {
+        return;
+    }
+
+    if(JoinButton)
+    {
+        JoinButton->SetIsEnabled(false);
+    }
+    bIsJoining = true;
+    MultiplayerSessionsSubsystem->JoinSession(Item->GetHandle());
+}
+
+void UW_SessionBrowser::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
+{
+    // Whoever started the other joins travels for them, e.g. UW_Menu or the quick match
+    if(!bIsJoining)
+    {
+        return;
+    }
+    bIsJoining = false;
+
+    if(JoinButton)
+    {
+        JoinButton->SetIsEnabled(true);
+    }
+    if(Result != EOnJoinSessionCompleteResult::Success)
+    {
+        return;
+    }
+
+    FString Address;
+    APlayerController* PlayerController = GetOwningPlayer();
+    if(PlayerController && MultiplayerSessionsSubsystem->GetResolvedConnectString(Address))
+    {
+        PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
+        UE_LOG(LogMultiplayerSessions, Log, TEXT("Session browser: travelling to %s."), *Address);
+        return;
+    }
+    UE_LOG(LogMultiplayerSessions, Error, TEXT("Session browser: no connect string for the joined session."));
+}
+
+void UW_SessionBrowser::NativeDestruct()
+{
+    BrowserTearDown();
+    Super::NativeDestruct();
+}
+
+void UW_SessionBrowser::BrowserTearDown()
+{
+    if(MultiplayerSessionsSubsystem)
+    {
+        MultiplayerSessionsSubsystem->CustomOnFindSessionsCompleteDelegate.RemoveAll(this);
+        MultiplayerSessionsSubsystem->CustomOnSessionSearchCacheUpdatedDelegate.RemoveAll(this);
+        MultiplayerSessionsSubsystem->CustomOnJoinSessionCompleteDelegate.RemoveAll(this);
+    }
+    SessionResults.Reset();
+}
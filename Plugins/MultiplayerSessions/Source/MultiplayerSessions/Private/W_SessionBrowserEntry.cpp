@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "W_SessionBrowserEntry.h"
+#include "Components/TextBlock.h"
+#include "OnlineSessionSettings.h"
+
+void USessionBrowserItem::Fill(const FSessionResultHandle& _Handle)
+{
+    Handle = _Handle;
+    const FOnlineSessionSearchResult* Result = Handle.Get();
+    if(!Result)
+    {
+        return;
+    }
+
+    OwningUserName = Result->Session.OwningUserName;
+    MatchType.Reset();
+    Result->Session.SessionSettings.Get(FName("MatchType"), MatchType);
+    PingInMs = Result->PingInMs;
+    OpenSlots = Result->Session.NumOpenPublicConnections;
+    MaxSlots = Result->Session.SessionSettings.NumPublicConnections;
+}
+
+void UW_SessionBrowserEntry::NativeOnListItemObjectSet(UObject* ListItemObject)
+{
+    IUserObjectListEntry::NativeOnListItemObjectSet(ListItemObject);
+
+    const USessionBrowserItem* Item = Cast<USessionBrowserItem>(ListItemObject);
+    if(!Item)
+    {
+        return;
+    }
+
+    OwningUserNameText->SetText(FText::FromString(Item->OwningUserName));
+    if(MatchTypeText)
+    {
+        MatchTypeText->SetText(FText::FromString(Item->MatchType));
+    }
+    if(PlayersText)
+    {
+        PlayersText->SetText(FText::Format(NSLOCTEXT("SessionBrowser", "Players", "{0}/{1}"), Item->MaxSlots - Item->OpenSlots, Item->MaxSlots));
+    }
+    if(PingText)
+    {
+        PingText->SetText(FText::AsNumber(Item->PingInMs));
+    }
+}
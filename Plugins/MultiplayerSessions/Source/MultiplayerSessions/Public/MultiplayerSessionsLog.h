@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionOperationType.h"
+
+/**
+ * @brief Log category of the plugin. Shipping builds only compile the warnings and errors in:
+ * the Log and Verbose lines of the happy paths are stripped with their arguments, so they cost nothing there.
+ */
+#if UE_BUILD_SHIPPING
+MULTIPLAYERSESSIONS_API DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, Warning);
+#else
+MULTIPLAYERSESSIONS_API DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
+#endif
+
+enum class ESessionEvent : uint8
+{
+	Requested,	// Queued
+	Started,	// Backend called
+	Completed,	// Backend answered
+	Failed,
+	TimedOut,
+	Cancelled,
+	CacheHit,
+	Retried,	// Code: number of the retry
+	Hedged,		// Code: 1 if the results found so far were kept, 0 if a narrower search replaced the slow one
+	ResultsFrom	// Find, Code: 0 the query of the search, 1 the results the slow search found so far, 2 the narrower hedge query
+};
+
+struct FSessionEventRecord
+{
+	double Time{0.0};
+	ESessionEvent Event{ESessionEvent::Requested};
+	ESessionOperationType Operation{ESessionOperationType::None};
+	int32 Code{0}; // Result code of the backend, meaning depends on the operation
+};
+
+/**
+ * @brief Ring buffer of the last session events. Recording one copies a few bytes and formats nothing,
+ * so it stays on in every build, and the events which led to a failure can be dumped when it happens.
+ */
+class MULTIPLAYERSESSIONS_API FSessionEventLog
+{
+public:
+
+	static constexpr int32 Capacity = 64;
+
+	void Record(ESessionEvent _Event, ESessionOperationType _Operation, int32 _Code = 0);
+
+	/**
+	 * @brief Write the events, oldest first.
+	 */
+	void Dump(FOutputDevice& _Ar, ELogVerbosity::Type _Verbosity = ELogVerbosity::Log) const;
+	void Empty();
+
+	int32 Num() const { return NumEvents; }
+
+private:
+
+	FSessionEventRecord Events[Capacity];
+	int32 NextEvent{0};
+	int32 NumEvents{0};
+};
@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "MultiplayerSessionsSettings.generated.h"
+
+/**
+ * @brief Session settings advertised by a host of one MatchType.
+ */
+USTRUCT()
+struct MULTIPLAYERSESSIONS_API FSessionSettingsProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	FString MatchType;
+
+	/**
+	 * @brief Capacity of the sessions of this MatchType. 0 keeps the number given to CreateSession.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Profile", meta = (ClampMin = "0"))
+	int32 NumPublicConnections{0};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	bool bAllowJoinInProgress{true};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	bool bAllowJoinViaPresence{true};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	bool bShouldAdvertise{true};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	bool bUsesPresence{true};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	bool bUseLobbiesIfAvailable{true};
+
+	/**
+	 * @brief Only sessions with the same build id find each other.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Profile")
+	int32 BuildUniqueId{1};
+};
+
+/**
+ * @brief Project settings of the plugin (Project Settings > Plugins > Multiplayer Sessions).
+ * Values are read from the [/Script/MultiplayerSessions.MultiplayerSessionsSettings] section of DefaultGame.ini.
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Multiplayer Sessions"))
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+
+	UMultiplayerSessionsSettings();
+
+	/**
+	 * @brief If true, a search with the same query as a recent one returns the cached results right away,
+	 * and the backend search only runs in the background to refresh them.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Cache")
+	bool bEnableSearchCache{true};
+
+	/**
+	 * @brief Time in seconds during which cached search results are considered fresh.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Cache", meta = (ClampMin = "0.0", Units = "s"))
+	float SearchCacheTimeToLive{30.f};
+
+	/**
+	 * @brief Advertised session settings indexed when search results arrive, so they can be looked up without scanning the results.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Results")
+	TArray<FName> IndexedSessionSettingKeys;
+
+	/**
+	 * @brief Searches with at least this many results are filtered, indexed and ranked on worker threads,
+	 * only the finished store comes back to the game thread. Smaller ones are not worth the frame it takes.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Results", meta = (ClampMin = "0"))
+	int32 AsyncResultProcessingThreshold{256};
+
+	/**
+	 * @brief Time in seconds after which an operation without answer from the backend is failed, so the next queued one can run.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Operations", meta = (ClampMin = "1.0", Units = "s"))
+	float CreateSessionTimeout{15.f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Operations", meta = (ClampMin = "1.0", Units = "s"))
+	float FindSessionsTimeout{20.f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Operations", meta = (ClampMin = "1.0", Units = "s"))
+	float JoinSessionTimeout{15.f};
+
+	/**
+	 * @brief A failed search (refused call or failed callback) is retried up to MaxFindRetries times before the failure is broadcast.
+	 * The delay doubles with each retry from FindRetryBaseDelay up to FindRetryMaxDelay, and FindRetryJitter of it is random,
+	 * so clients failing together don't retry together.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "0"))
+	int32 MaxFindRetries{3};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "0.0", Units = "s"))
+	float FindRetryBaseDelay{0.5f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "0.0", Units = "s"))
+	float FindRetryMaxDelay{8.f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float FindRetryJitter{0.5f};
+
+	/**
+	 * @brief Retry budget: each search earns FindRetryBudgetPerSearch retries, up to MaxFindRetryBudget, and each retry spends one.
+	 * When the backend is down for everyone, retries stay a fraction of the searches instead of piling on the outage.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "0.0"))
+	float FindRetryBudgetPerSearch{0.2f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "1.0"))
+	float MaxFindRetryBudget{5.f};
+
+	/**
+	 * @brief Hedge a search slower than the p95 of the last ones (once HedgeMinSamples searches were measured).
+	 * The session interface runs one search at a time, so the hedge can't race the slow search: the sessions it found so far win
+	 * if any is usable, otherwise it is replaced by a narrower search: at most HedgeMaxSearchResults sessions,
+	 * with at least HedgeMinOpenSlots free slots and at most HedgeMaxPingInMs of ping.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries")
+	bool bHedgeSearches{false};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "1", EditCondition = "bHedgeSearches"))
+	int32 HedgeMinSamples{20};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "1", EditCondition = "bHedgeSearches"))
+	int32 HedgeMaxSearchResults{50};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "1", EditCondition = "bHedgeSearches"))
+	int32 HedgeMinOpenSlots{2};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Search Retries", meta = (ClampMin = "1", Units = "ms", EditCondition = "bHedgeSearches"))
+	int32 HedgeMaxPingInMs{100};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Operations", meta = (ClampMin = "1.0", Units = "s"))
+	float DestroySessionTimeout{10.f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Operations", meta = (ClampMin = "1.0", Units = "s"))
+	float StartSessionTimeout{10.f};
+
+	/**
+	 * @brief Ranking of the candidate sessions before joining. Each term is normalized, the weights say how much it counts.
+	 * PingWeight: penalty per 100 ms of ping.
+	 * OpenSlotsWeight: bonus for having PreferredOpenSlots free slots (less chance to find the session full when the join lands).
+	 * FullerLobbyPreference: bonus for the share of taken slots (matches start sooner in fuller lobbies).
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking", meta = (ClampMin = "0.0"))
+	float PingWeight{1.f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking", meta = (ClampMin = "0.0"))
+	float OpenSlotsWeight{0.25f};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking", meta = (ClampMin = "1"))
+	int32 PreferredOpenSlots{2};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking", meta = (ClampMin = "0.0"))
+	float FullerLobbyPreference{0.5f};
+
+	/**
+	 * @brief Measure the ping of the best ranked candidates again, all at once, before choosing the one to join.
+	 * The advertised ping can be stale or missing. Candidates whose address can't be pinged keep their advertised ping.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking")
+	bool bProbeTopCandidates{false};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking", meta = (ClampMin = "1", EditCondition = "bProbeTopCandidates"))
+	int32 NumCandidatesToProbe{3};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ranking", meta = (ClampMin = "0.1", Units = "s", EditCondition = "bProbeTopCandidates"))
+	float ProbeTimeout{1.f};
+
+	/**
+	 * @brief Resolve the connect strings of the best ranked sessions as soon as a search completes, host names to IP addresses included,
+	 * so the travel after joining one of them does not wait for it.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Connection Warm-Up")
+	bool bPrewarmTopCandidates{true};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Connection Warm-Up", meta = (ClampMin = "1", EditCondition = "bPrewarmTopCandidates"))
+	int32 NumCandidatesToPrewarm{3};
+
+	/**
+	 * @brief Also send an echo to the prewarmed hosts. It primes the route to them, and the probe of the top candidates
+	 * reuses the measured ping instead of waiting for a new echo.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Connection Warm-Up", meta = (EditCondition = "bPrewarmTopCandidates"))
+	bool bWarmUpConnections{false};
+
+	/**
+	 * @brief Clients that see the same results would all join the same best session. Every candidate whose score is within
+	 * JoinSpreadTolerance of the best one can be picked instead, at random, weighted by its free slots. 0 always joins the best one.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Load Spreading", meta = (ClampMin = "0.0"))
+	float JoinSpreadTolerance{0.25f};
+
+	/**
+	 * @brief Reserve a slot through the party beacon of the host before the full join, and try the next candidate if the
+	 * host denies it. Hosts advertise ReservationBeaconPort, which must be the ListenPort of OnlineBeaconHost.
+	 * A host which doesn't answer on its beacon is joined without reservation.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Load Spreading")
+	bool bReserveSlotBeforeJoin{false};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Load Spreading", meta = (ClampMin = "1", EditCondition = "bReserveSlotBeforeJoin"))
+	int32 ReservationBeaconPort{15000};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Load Spreading", meta = (ClampMin = "1", EditCondition = "bReserveSlotBeforeJoin"))
+	int32 MaxReservationAttempts{3};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Load Spreading", meta = (ClampMin = "0.1", Units = "s", EditCondition = "bReserveSlotBeforeJoin"))
+	float ReservationTimeout{3.f};
+
+	/**
+	 * @brief Settings of the hosted sessions, per MatchType. They are read once when the subsystem starts.
+	 * A MatchType without profile uses DefaultSessionProfile.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Hosting")
+	TArray<FSessionSettingsProfile> SessionProfiles;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Hosting")
+	FSessionSettingsProfile DefaultSessionProfile;
+
+	/**
+	 * @brief When we already host a session, CreateSession updates it in place (match type, capacity...) with one backend call
+	 * if the backend allows it, instead of destroying it and creating a new one.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Hosting")
+	bool bRehostInPlace{true};
+
+	/**
+	 * @brief Start searching as soon as the menu opens and refresh the results every PrefetchInterval seconds,
+	 * so Join is answered from the search cache. The prefetch only runs when no other operation is queued, and is cancelled
+	 * when one is requested. The interval is kept under SearchCacheTimeToLive so the results never go stale.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Prefetch")
+	bool bPrefetchSessions{false};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Prefetch", meta = (ClampMin = "1.0", Units = "s", EditCondition = "bPrefetchSessions"))
+	float PrefetchInterval{20.f};
+
+	/**
+	 * @brief A dedicated server has no menu to host from: it creates its session when it starts.
+	 * -MatchType= and -NumPublicConnections= on the command line override these, to run instances of several kinds on one machine.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Dedicated Server")
+	bool bHostOnDedicatedServerStart{true};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Dedicated Server", meta = (EditCondition = "bHostOnDedicatedServerStart"))
+	FString DedicatedServerMatchType{TEXT("FreeForAll")};
+
+	UPROPERTY(Config, EditAnywhere, Category = "Dedicated Server", meta = (ClampMin = "1", EditCondition = "bHostOnDedicatedServerStart"))
+	int32 DedicatedServerNumPublicConnections{16};
+};
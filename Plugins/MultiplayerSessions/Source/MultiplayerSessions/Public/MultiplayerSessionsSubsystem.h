@@ -4,9 +4,20 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "GameFramework/OnlineReplStructs.h"
+#include "SessionSearchCache.h"
+#include "SessionRanking.h"
+#include "SessionLatencyStats.h"
+#include "SessionSettingsProfiles.h"
+#include "MultiplayerSessionsLog.h"
 #include "MultiplayerSessionsSubsystem.generated.h"
 
+class AOnlineBeaconHost;
+class APartyBeaconHost;
+class APartyBeaconClient;
+
 /**
  * @brief Declaring our own custom delegates for the Menu class to bind callbacks to
  * MULTICAST => Once it's broadcast, multiple classes can bind their functions to it
@@ -16,9 +27,36 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCustomOnCreateSessionCompleteDelega
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCustomOnDestroySessionCompleteDelegate, bool, bWasSuccessul);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCustomOnStartSessionCompleteDelegate, bool, bWasSuccessul);
 
-// These can't be DYNAMIC because the array of online sessions search result is not a UClass
-DECLARE_MULTICAST_DELEGATE_TwoParams(FCustomOnFindSessionsCompleteDelegate, const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessul); 
+// These can't be DYNAMIC because the online sessions search results are not a UClass.
+// Every listener receives the same shared, immutable results: don't copy them, keep the pointer or a FSessionResultHandle instead.
+// SessionResults is null when the search found nothing. Query is the search they answer, listeners skip the searches of others.
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FCustomOnFindSessionsCompleteDelegate, const FSessionSearchQuery& Query, const FSessionResultStorePtr& SessionResults, bool bWasSuccessul);
 DECLARE_MULTICAST_DELEGATE_OneParam(FCustomOnJoinSessionCompleteDelegate, EOnJoinSessionCompleteResult::Type Result);
+// Broadcast when a background refresh of cached search results found changes
+DECLARE_MULTICAST_DELEGATE_TwoParams(FCustomOnSessionSearchCacheUpdatedDelegate, const FSessionSearchQuery& Query, const FSessionResultStorePtr& SessionResults);
+// Broadcast after the Create, Join, Destroy and Start of one named session only, on top of the delegates above
+DECLARE_MULTICAST_DELEGATE_TwoParams(FCustomOnNamedSessionOperationCompleteDelegate, ESessionOperationType Type, bool bWasSuccessul);
+
+/**
+ * @brief How a quick match ended.
+ */
+enum class EQuickMatchResult : uint8
+{
+	Joined,	// Joined an existing session and travelling to it
+	Hosted,	// Nothing joinable in time, hosted a session and travelling to the lobby
+	Failed
+};
+DECLARE_MULTICAST_DELEGATE_OneParam(FCustomOnQuickMatchCompleteDelegate, EQuickMatchResult Result);
+
+/**
+ * @brief Connect info of a candidate session, resolved before the player joins it.
+ */
+struct FPrewarmedConnection
+{
+	FString Address;			// "Host:Port" with the host resolved to an IP address when it was a host name
+	int32 PingInMs{INDEX_NONE};	// Measured by the warm-up echo, INDEX_NONE until it is back
+	double PingTime{0.0};
+};
 
 
 /**
@@ -32,15 +70,124 @@ class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstan
 public:
 
 	UMultiplayerSessionsSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
 	
 	/**
 	* @brief To handle session functionality. The menu class will call these.
+	* _SessionName lets one process hold several sessions at once, e.g. a server advertising several lobbies.
+	* The game session is the one the players travel with; the others are advertised only.
 	**/
-	void CreateSession(int32 _NumPublicConnections, FString _MatchType);
+	void CreateSession(int32 _NumPublicConnections, FString _MatchType, FName _SessionName = NAME_GameSession);
 	void FindSessions(int32 _MaxSearchResult);
-	void JoinSession(const FOnlineSessionSearchResult& _SessionResult);
-	void DestroySession();
-	void StartSession();
+	void FindSessions(const FSessionSearchQuery& _Query);
+	void JoinSession(const FOnlineSessionSearchResult& _SessionResult, FName _SessionName = NAME_GameSession);
+	void JoinSession(const FSessionResultHandle& _SessionHandle, FName _SessionName = NAME_GameSession); // Preferred, the result is not copied
+
+	/**
+	 * @brief Join the best session of _MatchType among _SessionResults, ranked on ping, free slots and lobby fill (see the Ranking settings).
+	 * Sessions almost as good as the best one can be picked instead, and a slot can be reserved first (see the Load Spreading settings).
+	 * With bProbeTopCandidates, the ping of the best candidates is measured again first and the join starts once the probes are back.
+	 * @return false if _SessionResults has no session of _MatchType.
+	 */
+	bool JoinBestSession(const FSessionResultStorePtr& _SessionResults, const FString& _MatchType);
+	void DestroySession(FName _SessionName = NAME_GameSession);
+
+	/**
+	 * @brief Mark the hosted session as in progress, once the match is about to begin.
+	 */
+	void StartSession(FName _SessionName = NAME_GameSession);
+
+	/**
+	 * @brief Server side: add a connected player to the hosted session, or remove it, so its free slots stay right.
+	 * Needed on dedicated servers, where no local player joins the session. Players already registered are skipped.
+	 */
+	void RegisterPlayer(const FUniqueNetIdRepl& _PlayerId, FName _SessionName = NAME_GameSession);
+	void UnregisterPlayer(const FUniqueNetIdRepl& _PlayerId, FName _SessionName = NAME_GameSession);
+
+	/**
+	 * @brief Address to travel to for a joined session. Taken from the prewarmed connections when the session is one of them.
+	 * @return false if there is no such session or the backend can't resolve it.
+	 */
+	bool GetResolvedConnectString(FString& OutAddress, FName _SessionName = NAME_GameSession) const;
+	bool HasNamedSession(FName _SessionName) const;
+
+	/**
+	 * @brief Server side: accept slot reservations for the hosted session on the party beacon, when bReserveSlotBeforeJoin is set.
+	 * Call it once on the lobby map; the beacon goes away with the map. Release the reservation of a player who leaves.
+	 * @return false if the reservations are off, there is no such session, or the beacon could not listen.
+	 */
+	bool StartReservationHost(FName _SessionName = NAME_GameSession);
+	void StopReservationHost();
+	void ReleaseReservation(const FUniqueNetIdRepl& _PlayerId);
+
+	/**
+	 * @brief Load a map in the background and keep it in memory until it is travelled to, so a seamless travel to it
+	 * does not wait for a cold load. Loading another map replaces the previous one.
+	 * @param _MapPackageName Long package name, e.g. "/Game/ThirdPerson/Maps/ThirdPersonMap"
+	 */
+	void PreloadMap(const FString& _MapPackageName);
+	bool IsMapPreloaded(const FString& _MapPackageName) const;
+
+	/**
+	 * @brief Find-or-host in one call. Searches for a joinable session of _MatchType and joins it; if nothing joinable
+	 * is found within _Budget seconds, or the join fails, hosts a session instead and travels to the lobby.
+	 * The host settings are prepared while the search runs.
+	 * @param _PathToLobby Travel URL given to ServerTravel when hosting, e.g. "/Game/ThirdPerson/Maps/Lobby?listen"
+	 */
+	void QuickMatch(FString _MatchType, float _Budget, int32 _NumPublicConnections, FString _PathToLobby);
+	bool IsQuickMatchInProgress() const { return QuickMatchPhase != EQuickMatchPhase::None; }
+
+	/**
+	 * @brief Indexed results of the last completed (or cached) search, shared with the search cache and the listeners.
+	 */
+	FSessionResultStorePtr GetSessionResults() const { return LastSessionResults; }
+
+	/**
+	 * @brief Latencies of the last operations, see the MultiplayerSessions.Stats and MultiplayerSessions.StatsCsv console commands.
+	 */
+	const FSessionLatencyStats& GetLatencyStats() const { return LatencyStats; }
+	void ResetLatencyStats();
+
+	/**
+	 * @brief Last session events, dumped to the log when an operation fails. See the MultiplayerSessions.Events console command.
+	 */
+	const FSessionEventLog& GetEventLog() const { return EventLog; }
+
+	/**
+	 * @brief Keep the results of _Query warm in the search cache with low priority background searches,
+	 * so a later FindSessions(_Query) is answered right away. See the Prefetch settings.
+	 */
+	void StartPrefetch(const FSessionSearchQuery& _Query);
+	void StopPrefetch();
+	bool IsPrefetching() const { return PrefetchQuery.IsSet(); }
+
+	/**
+	 * @brief Forget the cached search results, the next search goes to the backend.
+	 */
+	void FlushSearchCache();
+
+	/**
+	 * @brief Whether the session interface hosts and searches LAN sessions, like the NULL subsystem.
+	 */
+	bool IsLANSubsystem() const { return bIsLANSubsystem; }
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 * @brief Run the subsystem against another session interface, e.g. FMockOnlineSession for the session flow benchmark.
+	 * nullptr goes back to the interface of the online subsystem.
+	 * @param _bIsLAN Whether _SessionInterface hosts and searches LAN sessions, like the NULL subsystem. Ignored with nullptr.
+	 * @return false if an operation is running or queued, the interface is not changed.
+	 */
+	bool OverrideSessionInterface(IOnlineSessionPtr _SessionInterface, bool _bIsLAN = false);
+#endif
+
+	/**
+	 * @brief Operation waiting for the backend, None when the subsystem is idle.
+	 */
+	ESessionOperationType GetCurrentOperation() const { return CurrentOperation.IsSet() ? CurrentOperation->Type : ESessionOperationType::None; }
+	int32 GetNumPendingOperations() const { return PendingOperations.Num(); }
 
 	/**
 	 * @brief Declaring our own custom delegates for the Menu class to bind callbacks to.
@@ -50,6 +197,13 @@ public:
 	FCustomOnJoinSessionCompleteDelegate CustomOnJoinSessionCompleteDelegate;
 	FCustomOnDestroySessionCompleteDelegate CustomOnDestroySessionCompleteDelegate;
 	FCustomOnStartSessionCompleteDelegate CustomOnStartSessionCompleteDelegate;
+	FCustomOnSessionSearchCacheUpdatedDelegate CustomOnSessionSearchCacheUpdatedDelegate;
+	FCustomOnQuickMatchCompleteDelegate CustomOnQuickMatchCompleteDelegate;
+
+	/**
+	 * @brief Completion of the operations of _SessionName only, for the listeners of one session among several.
+	 */
+	FCustomOnNamedSessionOperationCompleteDelegate& OnNamedSessionOperationComplete(FName _SessionName) { return NamedSessionDelegates.FindOrAdd(_SessionName); }
 
 protected:
 
@@ -62,12 +216,15 @@ protected:
 	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
 	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessfull);
 	void OnStartSessionComplete(FName SessionName, bool bWasSuccessfull);
+	void OnUpdateSessionComplete(FName SessionName, bool bWasSuccessfull);
 
 
 private:
 
 	IOnlineSessionPtr SessionInterface;
-	TSharedPtr<FOnlineSessionSettings> LastSessionSettings;
+	TSharedPtr<const FOnlineSessionSettings> LastSessionSettings;
+
+	FUniqueNetIdPtr GetLocalUserId() const;
 
 	/**
 	 * @brief To add to the Online Session Interface delegate list.
@@ -90,10 +247,246 @@ private:
 	FOnStartSessionCompleteDelegate StartSessionCompleteDelegate;
 	FDelegateHandle StartSessionCompleteDelegateHandle;
 
+	FOnUpdateSessionCompleteDelegate UpdateSessionCompleteDelegate;
+	FDelegateHandle UpdateSessionCompleteDelegateHandle;
+
 	TSharedPtr<FOnlineSessionSearch> LastSessionSearch;
 
-	bool bCreateSessionOnDestroy{false};
-	int32 LastNumPublicConnections;
-	FString LastMatchType;
+	/**
+	 * @brief Operation queue. Requests are queued and run one at a time, so a delegate handle is never overwritten
+	 * by a second request of the same kind, and a clicked button can't issue the same backend call twice.
+	 * Each operation starts the backend call in Execute, and ends in its completion callback or when it times out.
+	 */
+	struct FSessionOperation
+	{
+		ESessionOperationType Type{ESessionOperationType::None};
+		TFunction<void()> Execute;
+		double RequestTime{0.0}; // When it was queued
+
+		// Find only, to coalesce identical searches
+		FSessionSearchQuery Query;
+		bool bIsBackgroundRefresh{false};
+		bool bIsPrefetch{false}; // Cancelled as soon as another operation is requested
+
+		// Create, Join, Destroy and Start
+		FName SessionName{NAME_GameSession};
+
+		// Create only, set once an existing session was destroyed to make room for the new one
+		bool bDestroyedExistingSession{false};
+	};
+
+	void EnqueueOperation(FSessionOperation&& _Operation);
+	void PumpOperationQueue();
+	void EndOperation(ESessionOperationType _Type);
+	bool OnOperationTimeout(float DeltaTime);
+	float GetOperationTimeout(ESessionOperationType _Type) const;
+	void StartOperationTimeout();
+
+	/**
+	 * @brief Session of the running operation. A backend callback for another name is not ours: another session of
+	 * the process, or the engine itself, called the interface.
+	 */
+	FName GetOperationSessionName() const { return CurrentOperation.IsSet() ? CurrentOperation->SessionName : FName(NAME_GameSession); }
+	void BroadcastNamedSessionOperation(FName _SessionName, ESessionOperationType _Type, bool _bWasSuccessful);
+	TMap<FName, FCustomOnNamedSessionOperationCompleteDelegate> NamedSessionDelegates;
+
+	/**
+	 * @brief Merge a search into an identical one which is already queued or running.
+	 * @return true if the search was merged and must not be queued.
+	 */
+	bool CoalesceSearch(const FSessionSearchQuery& _Query, bool _bIsBackgroundRefresh);
+
+	TOptional<FSessionOperation> CurrentOperation;
+	TArray<FSessionOperation> PendingOperations;
+	FTSTicker::FDelegateHandle OperationTimeoutHandle;
+
+	void EnqueueCreateSession(TSharedRef<const FOnlineSessionSettings> _SessionSettings, FName _SessionName);
+	void ExecuteCreateSession(TSharedRef<const FOnlineSessionSettings> _SessionSettings, bool _bDestroyedExistingSession);
+
+	/**
+	 * @brief Rehost: apply _SessionSettings to the session we already host with one UpdateSession call,
+	 * instead of destroying it and creating a new one. Falls back to destroy and create if the update fails.
+	 */
+	bool CanUpdateSessionInPlace(const FNamedOnlineSession& _ExistingSession, const FOnlineSessionSettings& _SessionSettings) const;
+	void ExecuteUpdateSession(const FNamedOnlineSession& _ExistingSession, TSharedRef<const FOnlineSessionSettings> _SessionSettings);
+	void DestroyThenCreateSession(TSharedRef<const FOnlineSessionSettings> _SessionSettings);
+	TSharedPtr<const FOnlineSessionSettings> RehostSettings; // Settings of the running update, for the fallback
+
+	/**
+	 * @brief Host settings per MatchType, built in Initialize. The online subsystem does not change while the game runs,
+	 * so whether we host and search LAN sessions is decided there too.
+	 */
+	FSessionSettingsProfiles SessionProfiles;
+	bool bIsLANSubsystem{false};
+	void ExecuteJoinSession(const FOnlineSessionSearchResult& _SessionResult);
+	void ExecuteDestroySession();
+	void ExecuteStartSession();
+
+	/**
+	 * @brief Latency probe of the best ranked candidates. The echoes are sent all at once, the candidates are ranked
+	 * again with the measured pings when the last one is back, and the best one is joined.
+	 */
+	void ProbeCandidates(const FSessionResultStorePtr& _SessionResults, TArray<FRankedSession>&& _RankedSessions);
+	void OnCandidateProbed(uint32 _ProbeId, int32 _RankedIndex, int32 _PingInMs);
+	void FinishProbe();
+
+	FSessionResultStorePtr ProbedResults;
+	TArray<FRankedSession> ProbedSessions;
+	int32 NumPendingProbes{0};
+	uint32 ProbeId{0}; // Echoes of an older probe are ignored
+
+	/**
+	 * @brief Connection warm-up of the best ranked sessions of a search (see bPrewarmTopCandidates): their connect strings are resolved
+	 * ahead of the join, host names through an async DNS lookup, and an echo measures their ping if bWarmUpConnections is set.
+	 */
+	void PrewarmCandidates(const FSessionResultStorePtr& _SessionResults);
+	void OnPrewarmHostResolved(uint32 _PrewarmId, const FString& _SessionId, const FString& _Address);
+	void WarmUpConnection(const FString& _SessionId, const FString& _Address);
+	const FPrewarmedConnection* FindPrewarmedConnection(const FString& _SessionId) const;
+
+	TMap<FString, FPrewarmedConnection> PrewarmedConnections; // Session id => connection
+	uint32 PrewarmId{0}; // Lookups and echoes of an older search are ignored
+
+	/**
+	 * @brief Join one of the ranked sessions, picked with FSessionRanking::PickSpread, after reserving a slot in it if
+	 * bReserveSlotBeforeJoin is set. A denied reservation moves to the next candidate, up to MaxReservationAttempts.
+	 */
+	void JoinRankedSession(const FSessionResultStorePtr& _SessionResults, TArray<FRankedSession>&& _RankedSessions);
+	void ReserveNextCandidate();
+	void OnReservationComplete(uint32 _ReservationId, bool _bAccepted);
+	void OnReservationHostUnreachable(uint32 _ReservationId);
+	void EndReservation();
+
+	FRandomStream JoinRandom;
+	FSessionResultStorePtr ReservationResults;
+	TArray<int32> ReservationCandidates; // Indices in ReservationResults, in the order they are tried
+	int32 NextReservationCandidate{0};
+	uint32 ReservationId{0}; // Answers of an older reservation are ignored
+	TWeakObjectPtr<APartyBeaconClient> ReservationClient;
+	FTSTicker::FDelegateHandle ReservationTimeoutHandle;
+
+	TWeakObjectPtr<AOnlineBeaconHost> ReservationBeaconHost;
+	TWeakObjectPtr<APartyBeaconHost> ReservationHost;
+
+	/**
+	 * @brief Remove a search from the queue, or cancel it if it is running. Its listeners get a failed result.
+	 */
+	void CancelSearch(const FSessionSearchQuery& _Query);
+
+	bool OnPrefetchTick(float DeltaTime);
+	void YieldPrefetch();
+	TOptional<FSessionSearchQuery> PrefetchQuery;
+	FTSTicker::FDelegateHandle PrefetchTickerHandle;
+
+	/**
+	 * @brief Quick match pipeline. The steps are driven from the completion callbacks, after the public broadcast,
+	 * so listeners of the public delegates can check IsQuickMatchInProgress() and leave the travel to the subsystem.
+	 */
+	enum class EQuickMatchPhase : uint8
+	{
+		None,
+		Searching,
+		Joining,
+		Hosting
+	};
+
+	void OnQuickMatchSearchComplete(const FSessionResultStorePtr& _SessionResults);
+	void OnQuickMatchJoinComplete(EOnJoinSessionCompleteResult::Type _Result);
+	void OnQuickMatchHostComplete(bool _bWasSuccessful);
+	bool OnQuickMatchDeadline(float DeltaTime);
+	void StartQuickMatchHost();
+	void EndQuickMatch(EQuickMatchResult _Result);
+
+	EQuickMatchPhase QuickMatchPhase{EQuickMatchPhase::None};
+	FSessionSearchQuery QuickMatchQuery;
+	FString QuickMatchPathToLobby;
+	TSharedPtr<const FOnlineSessionSettings> QuickMatchHostSettings;
+	FTSTicker::FDelegateHandle QuickMatchDeadlineHandle;
+
+	/**
+	 * @brief Search result cache. A repeated search inside the time to live is answered from here,
+	 * while the backend search runs in the background to bring in the changes.
+	 */
+	void StartSessionSearch(const FSessionSearchQuery& _Query, bool _bIsBackgroundRefresh);
+
+	/**
+	 * @brief Call the backend for the current search. Retries and hedges send again, LastSearchQuery stays the query of the search.
+	 * @param _BackendQuery LastSearchQuery, or a narrower one for a hedge
+	 */
+	void SendSessionSearch(const FSessionSearchQuery& _BackendQuery);
+	void CompleteSessionSearch(TArray<FOnlineSessionSearchResult>&& _Results, bool _bWasSuccessful);
+	void FinishSessionSearch(const FSessionResultStorePtr& _Results, bool _bWasSuccessful);
+	bool IsSearchInProgress() const;
+
+	/**
+	 * @brief "Stop at first result" searches: poll the results while they arrive and cancel the search at the first usable one.
+	 */
+	bool PollFirstAcceptableResult(float DeltaTime);
+	void StopPollingFirstResult();
+
+	FTSTicker::FDelegateHandle FirstResultTickerHandle;
+	int32 NumPolledSearchResults{0};
+
+	/**
+	 * @brief Retries of failed searches, with exponential backoff and jitter, within the retry budget.
+	 * @return false if the search has no retry left, it fails now.
+	 */
+	bool ScheduleSearchRetry();
+	bool OnSearchRetryDelay(float DeltaTime);
+	void StopSearchRetry();
+
+	FTSTicker::FDelegateHandle SearchRetryHandle;
+	int32 NumFindRetries{0};
+	float FindRetryBudget{0.f};
+	FRandomStream RetryRandom;
+
+	/**
+	 * @brief Hedge of searches slower than the p95 of SearchLatency, see bHedgeSearches.
+	 */
+	void ScheduleSearchHedge();
+	bool OnSearchHedgeDelay(float DeltaTime);
+	void StopSearchHedge();
+
+	FTSTicker::FDelegateHandle SearchHedgeHandle;
+	bool bIsHedgeSearch{false};
+	bool bKeptPartialResults{false};
+	FSessionSearchQuery HedgeSearchQuery; // Sent instead of LastSearchQuery while bIsHedgeSearch
+	double SearchSendTime{0.0};
+	FSessionLatencyHistogram SearchLatency{128}; // Backend time of the full searches that succeeded, queue and retries excluded
+
+	/**
+	 * @brief Instrumentation. The request phase ends in EndOperation, the travel phase when the map the following travel goes to
+	 * is loaded (after the transition map for a seamless travel).
+	 */
+	void MarkTravelStart(ESessionOperationType _Type);
+	void EndTravel(const FString& MapName);
+	void OnSeamlessTravelStart(UWorld* World, const FString& MapName);
+	void OnSeamlessTravelTransition(UWorld* World);
+	static bool IsTransitionMap(const UWorld* _World);
+
+	FSessionLatencyStats LatencyStats;
+	FSessionEventLog EventLog;
+	void LogOperationFailure(ESessionOperationType _Type, const TCHAR* _Reason, int32 _Code = 0);
+	ESessionOperationType PendingTravelOperation{ESessionOperationType::None};
+	double PendingTravelStartTime{0.0};
+	FDelegateHandle SeamlessTravelStartHandle;
+	FDelegateHandle SeamlessTravelTransitionHandle;
+
+	void OnMapPreloaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	// Held here, the game instance outlives the worlds a seamless travel goes through
+	UPROPERTY()
+	TObjectPtr<UPackage> PreloadedMap;
+	FString PreloadingMapName;
+	FString PreloadingFromMapName;
+	FDelegateHandle PostLoadMapHandle;
+
+	FSessionSearchCache SearchCache;
+	uint32 SearchProcessingId{0}; // Results processed for a cancelled or timed out search are dropped
+	FSessionResultStorePtr LastSessionResults;
+	FSessionSearchQuery LastSearchQuery;
+	bool bIsBackgroundRefresh{false};
+	FString LastJoinSessionId;
 
 };
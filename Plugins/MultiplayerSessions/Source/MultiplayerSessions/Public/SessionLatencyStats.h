@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionOperationType.h"
+
+/**
+ * @brief Rolling window of the last latencies of one kind, with percentiles.
+ * Old samples are overwritten, so the percentiles follow what players get now, not since startup.
+ */
+class MULTIPLAYERSESSIONS_API FSessionLatencyHistogram
+{
+public:
+
+	explicit FSessionLatencyHistogram(int32 _Capacity = 512);
+
+	void AddSample(double _Seconds);
+	void Reset();
+
+	int32 Num() const { return Samples.Num(); }
+
+	/**
+	 * @param _Percentile From 0 to 1, e.g. 0.95
+	 * @return The latency in seconds below which _Percentile of the samples of the window are, 0 if there is no sample.
+	 */
+	double GetPercentile(double _Percentile) const;
+	double GetMax() const;
+
+	/**
+	 * @brief p50, p95 and p99 in one sort of the window.
+	 */
+	void GetPercentiles(double& OutP50, double& OutP95, double& OutP99) const;
+
+private:
+
+	TArray<float> Samples;
+	int32 Capacity;
+	int32 NextSample{0}; // Oldest sample once the window is full
+};
+
+/**
+ * @brief Where the time of an operation goes.
+ */
+enum class ESessionLatencyPhase : uint8
+{
+	Request,	// From the call to the subsystem to the backend callback, the wait in the operation queue included
+	Travel,		// From the backend callback to the end of the map load of the travel (Create, Join, and Start for the seamless travel to the match)
+	Num
+};
+
+/**
+ * @brief Latency histograms of the subsystem, per operation and per phase.
+ */
+class MULTIPLAYERSESSIONS_API FSessionLatencyStats
+{
+public:
+
+	void Record(ESessionOperationType _Type, ESessionLatencyPhase _Phase, double _Seconds);
+	void RecordTimeout(ESessionOperationType _Type);
+	void Reset();
+
+	const FSessionLatencyHistogram& Get(ESessionOperationType _Type, ESessionLatencyPhase _Phase) const;
+	int32 GetNumTimeouts(ESessionOperationType _Type) const { return NumTimeouts[static_cast<int32>(_Type)]; }
+
+	/**
+	 * @brief One line per operation and phase: Operation,Phase,Samples,Timeouts,P50Ms,P95Ms,P99Ms,MaxMs
+	 */
+	FString ToCsv() const;
+	void Dump(FOutputDevice& _Ar) const;
+
+private:
+
+	static constexpr int32 NumTypes = static_cast<int32>(ESessionOperationType::Num);
+	static constexpr int32 NumPhases = static_cast<int32>(ESessionLatencyPhase::Num);
+
+	FSessionLatencyHistogram Histograms[NumTypes][NumPhases];
+	int32 NumTimeouts[NumTypes]{};
+};
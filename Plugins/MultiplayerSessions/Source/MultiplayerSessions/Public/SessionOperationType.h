@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @brief Backend operations of the subsystem. Only one runs at a time, the others wait in the operation queue.
+ */
+enum class ESessionOperationType : uint8
+{
+	None,
+	Create,
+	Find,
+	Join,
+	Destroy,
+	Start,
+	Num
+};
+
+inline const TCHAR* LexToString(ESessionOperationType _Type)
+{
+	switch(_Type)
+	{
+	case ESessionOperationType::Create:		return TEXT("Create");
+	case ESessionOperationType::Find:		return TEXT("Find");
+	case ESessionOperationType::Join:		return TEXT("Join");
+	case ESessionOperationType::Destroy:	return TEXT("Destroy");
+	case ESessionOperationType::Start:		return TEXT("Start");
+	default:								return TEXT("None");
+	}
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FSessionResultColumns;
+class FSessionResultStore;
+
+/**
+ * @brief A candidate session and its score, higher is better.
+ */
+struct MULTIPLAYERSESSIONS_API FRankedSession
+{
+	int32 Index{INDEX_NONE}; // In the result store
+	int32 PingInMs{0};
+	float Score{0.f};
+};
+
+/**
+ * @brief Scores candidate sessions on ping, free slots and how full the lobby is, so we join the best one
+ * instead of the first one the backend returned.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionRanking
+{
+	float PingWeight{1.f};
+	float OpenSlotsWeight{0.25f};
+	int32 PreferredOpenSlots{2};
+	float FullerLobbyPreference{0.5f};
+	float JoinSpreadTolerance{0.f};
+
+	/**
+	 * @brief Weights of the project settings.
+	 */
+	static FSessionRanking FromSettings();
+
+	/**
+	 * @param _Index Row of the result in _Columns
+	 * @param _PingInMs Ping to use instead of the advertised one, e.g. a fresh measure
+	 */
+	float Score(const FSessionResultColumns& _Columns, int32 _Index, int32 _PingInMs) const;
+
+	/**
+	 * @brief Score every result with its advertised ping. The scores are computed in parallel, safe on any thread.
+	 * @return Every row of _Columns, best first. Ties keep the search order.
+	 */
+	TArray<FRankedSession> Rank(const FSessionResultColumns& _Columns) const;
+
+	/**
+	 * @brief Score the sessions again after their ping changed, and sort them again.
+	 */
+	void Rerank(const FSessionResultStore& _Store, TArray<FRankedSession>& _RankedSessions) const;
+
+	/**
+	 * @brief Pick the session to join among the ranked ones: at random among those within JoinSpreadTolerance of the best score,
+	 * weighted by their free slots, so clients seeing the same results spread over the lobbies.
+	 * @return Position in _RankedSessions, INDEX_NONE if it is empty.
+	 */
+	int32 PickSpread(const FSessionResultStore& _Store, TConstArrayView<FRankedSession> _RankedSessions, FRandomStream& _Random) const;
+};
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "SessionRanking.h"
+
+class FSessionResultStore;
+
+/**
+ * @brief Immutable results of a search, shared by the subsystem, the search cache, every listener and the join path.
+ */
+using FSessionResultStorePtr = TSharedPtr<const FSessionResultStore, ESPMode::ThreadSafe>;
+using FSessionResultStoreRef = TSharedRef<const FSessionResultStore, ESPMode::ThreadSafe>;
+
+/**
+ * @brief Lightweight reference to one result of a FSessionResultStore.
+ * It keeps its store alive, so it stays valid after newer searches complete.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionResultHandle
+{
+	FSessionResultHandle() = default;
+	FSessionResultHandle(FSessionResultStorePtr _Store, int32 _Index) : Store(MoveTemp(_Store)), Index(_Index) {}
+
+	bool IsValid() const { return Store.IsValid() && Index != INDEX_NONE; }
+
+	/**
+	 * @brief The result in the store, never a copy. nullptr if the handle is not valid.
+	 */
+	const FOnlineSessionSearchResult* Get() const;
+
+	const FSessionResultStorePtr& GetStore() const { return Store; }
+	int32 GetIndex() const { return Index; }
+
+private:
+
+	FSessionResultStorePtr Store;
+	int32 Index{INDEX_NONE};
+};
+
+/**
+ * @brief The fields of the results that filtering and ranking read, one array per field, row i being result i.
+ * Extracted once per search, so the hot loops walk a few packed arrays instead of each result's settings map.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionResultColumns
+{
+	TArray<int32> PingInMs;
+	TArray<int32> OpenSlots;
+	TArray<int32> MaxSlots;
+	TArray<int32> BuildUniqueId;
+	TArray<uint32> MatchTypeHash; // See HashMatchType
+
+	int32 Num() const { return PingInMs.Num(); }
+
+	/**
+	 * @brief Extract the columns of _Results. The rows are filled in parallel, safe on any thread.
+	 */
+	static FSessionResultColumns Extract(TConstArrayView<FOnlineSessionSearchResult> _Results);
+
+	/**
+	 * @brief Case insensitive like the MatchType comparisons, an empty or missing MatchType hashes as an empty string.
+	 */
+	static uint32 HashMatchType(const FString& _MatchType) { return GetTypeHash(_MatchType); }
+
+	void MoveRow(int32 _From, int32 _To);
+	void SetNum(int32 _Num);
+};
+
+/**
+ * @brief Owns the results of one completed search and indexes them by the advertised settings (MatchType...).
+ * The index is built once when the results arrive, so a lookup is a hash lookup instead of a scan of all the results.
+ * A store is never modified once built: create it with Create() and share the returned reference.
+ */
+class MULTIPLAYERSESSIONS_API FSessionResultStore : public TSharedFromThis<FSessionResultStore, ESPMode::ThreadSafe>
+{
+public:
+
+	/**
+	 * @brief Building a store scales with the number of results, large searches build it on a worker thread.
+	 * @param _Results Results of the search, moved into the store
+	 * @param _IndexedKeys Advertised session settings to index, e.g. MatchType
+	 * @param _Ranking Weights the results are ranked with once here
+	 */
+	static FSessionResultStoreRef Create(TArray<FOnlineSessionSearchResult>&& _Results, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking);
+
+	/**
+	 * @param _Columns Columns already extracted from _Results, moved into the store
+	 */
+	static FSessionResultStoreRef Create(TArray<FOnlineSessionSearchResult>&& _Results, FSessionResultColumns&& _Columns, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking);
+
+	const TArray<FOnlineSessionSearchResult>& GetResults() const { return Results; }
+	const FSessionResultColumns& GetColumns() const { return Columns; }
+	int32 Num() const { return Results.Num(); }
+
+	FSessionResultHandle MakeHandle(int32 _Index) const;
+
+	/**
+	 * @brief Indices of the results which advertise _Value for the setting _Key, in search order.
+	 * Empty if _Key is not indexed.
+	 */
+	TConstArrayView<int32> Find(FName _Key, FName _Value) const;
+	FSessionResultHandle FindFirst(FName _Key, FName _Value) const;
+
+	bool IsIndexed(FName _Key) const { return Index.Contains(_Key); }
+
+	/**
+	 * @brief Every result, best first, ranked when the store was built.
+	 */
+	TConstArrayView<FRankedSession> GetRankedSessions() const { return RankedSessions; }
+
+	/**
+	 * @brief The ranking of some of the results, taken from GetRankedSessions without scoring them again.
+	 * @param _Candidates Indices of results, every result if empty
+	 * @return The candidates, best first. Ties keep the search order.
+	 */
+	TArray<FRankedSession> RankCandidates(TConstArrayView<int32> _Candidates) const;
+
+	/**
+	 * @brief Number of stores created since startup. A search allocates one store whatever the number of listeners and results.
+	 */
+	static uint32 GetNumCreated();
+
+private:
+
+	FSessionResultStore(TArray<FOnlineSessionSearchResult>&& _Results, FSessionResultColumns&& _Columns, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking);
+
+	TArray<FOnlineSessionSearchResult> Results;
+	FSessionResultColumns Columns;
+	TArray<FRankedSession> RankedSessions;
+
+	// Setting key => setting value => results advertising it. Keys and values are FNames so they are interned and hashed once.
+	TMap<FName, TMap<FName, TArray<int32>>> Index;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "SessionResultStore.h"
+#include "SessionSearchQuery.h"
+
+/**
+ * @brief Keeps the results of recent session searches, keyed by query, for a limited time.
+ * Lets the subsystem answer a repeated search right away instead of waiting for the backend.
+ */
+class MULTIPLAYERSESSIONS_API FSessionSearchCache
+{
+public:
+
+	void SetTimeToLive(double _Seconds) { TimeToLive = _Seconds; }
+
+	/**
+	 * @brief Get the cached results of a query.
+	 * @return nullptr if the query is not cached or if its results are older than the time to live.
+	 */
+	FSessionResultStorePtr Find(const FSessionSearchQuery& _Query, double _Now) const;
+
+	/**
+	 * @brief Get the stored results of a query, even if they are expired.
+	 */
+	FSessionResultStorePtr FindAny(const FSessionSearchQuery& _Query) const;
+
+	/**
+	 * @brief Store the results of a completed search and refresh their timestamp.
+	 * A search whose results are equivalent to the stored ones should pass the stored store again, see AreResultsEquivalent.
+	 * @return true if the stored results are different from the previous ones.
+	 */
+	bool Store(const FSessionSearchQuery& _Query, const FSessionResultStoreRef& _Results, double _Now);
+
+	void Remove(const FSessionSearchQuery& _Query);
+
+	/**
+	 * @brief Forget a session in every cached query, e.g. after we failed to join it.
+	 * A query left without any session is evicted, so the next search for it goes to the backend.
+	 */
+	void RemoveSession(const FString& _SessionId, TConstArrayView<FName> _IndexedKeys, const FSessionRanking& _Ranking);
+
+	void Empty() { Entries.Empty(); }
+
+	/**
+	 * @brief Two searches are equivalent if they found the same sessions, with the same ping and the same free slots.
+	 * Only reads its arguments, safe on any thread.
+	 */
+	static bool AreResultsEquivalent(const TArray<FOnlineSessionSearchResult>& A, const TArray<FOnlineSessionSearchResult>& B);
+
+private:
+
+	struct FEntry
+	{
+		FSessionResultStorePtr Results;
+		double Timestamp{0.0};
+	};
+
+	TMap<FSessionSearchQuery, FEntry> Entries;
+	double TimeToLive{30.0};
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSearch;
+class FOnlineSessionSearchResult;
+struct FSessionResultColumns;
+
+/**
+ * @brief Parameters of a session search.
+ * The filters are sent to the backend as QuerySettings, so it only returns the sessions we can use.
+ * Everything but MaxSearchResults also identifies the search in the search cache.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionSearchQuery
+{
+	// Kind of game we are looking for, empty means any
+	FString MatchType;
+
+	// Minimum number of free public slots, 0 means any
+	int32 MinOpenSlots{0};
+
+	// Only sessions hosted with this BuildUniqueId, 0 means any
+	int32 BuildUniqueId{0};
+
+	// Maximum ping of the sessions, 0 means any. Backends have no such filter, it is checked when the results arrive
+	int32 MaxPingInMs{0};
+
+	bool bIsLanQuery{false};
+	bool bSearchPresence{true};
+
+	// Cancel the search as soon as one acceptable session shows up (quick play)
+	bool bStopAtFirstResult{false};
+
+	// Not part of the cache key: a bigger search does not change which sessions exist
+	int32 MaxSearchResults{10000};
+
+	/**
+	 * @brief Turn the filters into QuerySettings constraints of a backend search.
+	 */
+	void ApplyTo(FOnlineSessionSearch& _Search) const;
+
+	/**
+	 * @brief Check the filters on a result. Backends are free to ignore custom QuerySettings (e.g. the NULL subsystem),
+	 * so results are checked again when they arrive.
+	 */
+	bool IsAcceptable(const FOnlineSessionSearchResult& _Result) const;
+
+	/**
+	 * @brief Remove the results which are not acceptable, and their rows of _Columns.
+	 * The filters are checked on the columns in parallel, safe on any thread.
+	 */
+	void Filter(TArray<FOnlineSessionSearchResult>& _Results, FSessionResultColumns& _Columns) const;
+
+	bool operator==(const FSessionSearchQuery& Other) const
+	{
+		return MatchType == Other.MatchType
+			&& MinOpenSlots == Other.MinOpenSlots
+			&& BuildUniqueId == Other.BuildUniqueId
+			&& MaxPingInMs == Other.MaxPingInMs
+			&& bIsLanQuery == Other.bIsLanQuery
+			&& bSearchPresence == Other.bSearchPresence
+			&& bStopAtFirstResult == Other.bStopAtFirstResult;
+	}
+
+	bool operator!=(const FSessionSearchQuery& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	friend uint32 GetTypeHash(const FSessionSearchQuery& Query)
+	{
+		uint32 Hash = GetTypeHash(Query.MatchType);
+		Hash = HashCombine(Hash, GetTypeHash(Query.MinOpenSlots));
+		Hash = HashCombine(Hash, GetTypeHash(Query.BuildUniqueId));
+		Hash = HashCombine(Hash, GetTypeHash(Query.MaxPingInMs));
+		Hash = HashCombine(Hash, GetTypeHash(Query.bIsLanQuery));
+		Hash = HashCombine(Hash, GetTypeHash(Query.bSearchPresence));
+		return HashCombine(Hash, GetTypeHash(Query.bStopAtFirstResult));
+	}
+};
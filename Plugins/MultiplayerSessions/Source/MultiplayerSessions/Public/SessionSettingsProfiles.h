@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSettings;
+class UMultiplayerSessionsSettings;
+struct FSessionSettingsProfile;
+
+/**
+ * @brief Host session settings built once per MatchType from the Hosting project settings.
+ * The templates are immutable and shared: a host whose capacity matches its profile gets the template itself,
+ * otherwise a copy with the requested capacity.
+ */
+class MULTIPLAYERSESSIONS_API FSessionSettingsProfiles
+{
+public:
+
+	/**
+	 * @brief Validate the profiles of _Settings and build their templates. Invalid or duplicate profiles are logged and skipped.
+	 * @param _bIsLANMatch Whether the hosted sessions are LAN ones (NULL online subsystem)
+	 * @param _bIsDedicated Hosted by a dedicated server: no host player, so no presence nor lobby
+	 */
+	void Build(const UMultiplayerSessionsSettings& _Settings, bool _bIsLANMatch, bool _bIsDedicated);
+
+	/**
+	 * @param _NumPublicConnections Used when the profile of _MatchType does not set a capacity
+	 */
+	TSharedRef<const FOnlineSessionSettings> MakeSettings(const FString& _MatchType, int32 _NumPublicConnections) const;
+
+	int32 Num() const { return Templates.Num(); }
+
+private:
+
+	struct FTemplate
+	{
+		TSharedRef<const FOnlineSessionSettings> Settings;
+		bool bFixedCapacity; // The profile sets NumPublicConnections
+	};
+
+	FTemplate MakeTemplate(const FSessionSettingsProfile& _Profile, const FString& _MatchType) const;
+
+	TMap<FString, FTemplate> Templates;
+	TOptional<FTemplate> DefaultTemplate; // MatchType not set, it is the one of the host
+	bool bIsLANMatch{false};
+	bool bIsDedicated{false};
+	int32 BeaconPort{0}; // Advertised for the slot reservations, 0 if they are off
+};
@@ -28,8 +28,9 @@ protected:
 	 */
 	UFUNCTION()
 	void OnCreateSession(bool bWasSuccessful);
-	void OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResult, bool bWasSuccessful);
+	void OnFindSessions(const FSessionSearchQuery& Query, const FSessionResultStorePtr& SessionResults, bool bWasSuccessful);
 	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);
+	void OnQuickMatch(EQuickMatchResult Result);
 
 	UFUNCTION()
 	void OnDestroySession(bool bWasSuccessful);
@@ -45,12 +46,27 @@ private:
 	UPROPERTY(meta = (BindWidget)) // Link to the variable JoinButton in the BP widget children
 	class UButton* JoinButton;
 
+	UPROPERTY(meta = (BindWidgetOptional)) // Link to the variable QuickMatchButton in the BP widget children, if there is one
+	class UButton* QuickMatchButton;
+
+	// Time in seconds a quick match searches for a session to join before hosting one
+	UPROPERTY(EditAnywhere, Category = "Quick Match", meta = (ClampMin = "0.0", Units = "s"))
+	float QuickMatchBudget{5.f};
+
 	UFUNCTION()
 	void HostButtonClicked();
 
 	UFUNCTION()
 	void JoinButtonClicked();
 
+	UFUNCTION()
+	void QuickMatchButtonClicked();
+
+	void SetButtonsEnabled(bool bEnabled);
+
+	// Same query for the prefetch and the Join button, so the click is answered from the prefetched results
+	FSessionSearchQuery MakeJoinQuery() const;
+
 	void MenuTearDown();
 
 	// Our custom Subsystem designed to handle all online session functioality
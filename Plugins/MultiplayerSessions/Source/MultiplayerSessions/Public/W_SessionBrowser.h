@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "W_SessionBrowser.generated.h"
+
+class USessionBrowserItem;
+
+UENUM(BlueprintType)
+enum class ESessionBrowserSort : uint8
+{
+	Ping,
+	OpenSlots,
+	OwningUserName,
+	MatchType
+};
+
+/**
+ * @brief Lists the sessions found by the subsystem and joins the one the player picks, instead of joining blindly like UW_Menu.
+ * The rows are a UListView: only the rows on screen exist as widgets, and they are reused while scrolling.
+ * A search is added to the list ItemsPerFrame results per frame, so 10k results never stall a frame,
+ * and sorting or filtering only reorders the items, no widget is created.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UW_SessionBrowser : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * @brief Bind to the subsystem and start a search.
+	 * @param _MatchType Only list sessions of this kind of game, any if empty
+	 */
+	UFUNCTION(BlueprintCallable)
+	void BrowserSetup(FString _MatchType = FString());
+
+	UFUNCTION(BlueprintCallable)
+	void Refresh();
+
+	UFUNCTION(BlueprintCallable)
+	void SetSort(ESessionBrowserSort _SortBy, bool _bAscending = true);
+
+	/**
+	 * @param _NameFilter Only list the sessions whose host name contains it, any if empty
+	 * @param _bHideFull Hide the sessions without a free slot
+	 */
+	UFUNCTION(BlueprintCallable)
+	void SetFilter(const FString& _NameFilter, bool _bHideFull);
+
+	UFUNCTION(BlueprintCallable)
+	void JoinSelected();
+
+protected:
+
+	virtual bool Initialize() override;
+	virtual void NativeDestruct() override;
+	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+
+	/**
+	 * @brief Callbacks for the custom delegates on the MultiplayerSessionsSubsystem.
+	 * Only the results of SearchQuery and the joins started by JoinSelected are handled: the menu, its prefetch
+	 * and the quick match search and join through the same subsystem.
+	 */
+	void OnFindSessions(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults, bool bWasSuccessful);
+	void OnSearchCacheUpdated(const FSessionSearchQuery& _Query, const FSessionResultStorePtr& _SessionResults);
+	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);
+
+private:
+
+	UPROPERTY(meta = (BindWidget)) // Its entry widget class must be a UW_SessionBrowserEntry
+	class UListView* SessionList;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton* RefreshButton;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton* JoinButton;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UEditableTextBox* NameFilterBox;
+
+	// Search results added to the list each frame
+	UPROPERTY(EditAnywhere, Category = "Session Browser", meta = (ClampMin = "1"))
+	int32 ItemsPerFrame{500};
+
+	UPROPERTY(EditAnywhere, Category = "Session Browser", meta = (ClampMin = "1"))
+	int32 MaxSearchResults{10000};
+
+	UFUNCTION()
+	void RefreshButtonClicked();
+
+	UFUNCTION()
+	void JoinButtonClicked();
+
+	UFUNCTION()
+	void NameFilterChanged(const FText& Text);
+
+	void StartPopulating(const FSessionResultStorePtr& _SessionResults);
+	void PopulateNextItems();
+
+	bool PassesFilter(const USessionBrowserItem& _Item) const;
+	bool IsBefore(const USessionBrowserItem& _A, const USessionBrowserItem& _B) const;
+
+	/**
+	 * @brief Filter and sort the items already populated again, after the sort or the filter changed.
+	 */
+	void ApplySortAndFilter();
+
+	void BrowserTearDown();
+
+	UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem;
+
+	FSessionResultStorePtr SessionResults;
+	int32 NumPopulated{0};
+
+	// One item per search result, reused by the following searches
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USessionBrowserItem>> ItemPool;
+
+	// Filtered and sorted, what the list shows
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UObject>> VisibleItems;
+
+	// Scratch arrays of the incremental population, kept to not allocate each frame
+	TArray<USessionBrowserItem*> NewItems;
+	TArray<TObjectPtr<UObject>> MergedItems;
+
+	// The search of the last Refresh, the only one the list shows
+	FSessionSearchQuery SearchQuery;
+	// Set by JoinSelected until its join completes
+	bool bIsJoining{false};
+
+	FString MatchType;
+	FString NameFilter;
+	bool bHideFull{false};
+	ESessionBrowserSort SortBy{ESessionBrowserSort::Ping};
+	bool bSortAscending{true};
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Blueprint/IUserObjectListEntry.h"
+#include "SessionResultStore.h"
+#include "W_SessionBrowserEntry.generated.h"
+
+/**
+ * @brief One row of the session browser. The sort and filter keys are copied out of the search result when the row is filled,
+ * so sorting and filtering never reach into the results. Items are pooled by the browser and refilled by each search.
+ */
+UCLASS(BlueprintType)
+class MULTIPLAYERSESSIONS_API USessionBrowserItem : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void Fill(const FSessionResultHandle& _Handle);
+
+	const FSessionResultHandle& GetHandle() const { return Handle; }
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	FString OwningUserName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	FString MatchType;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	int32 PingInMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	int32 OpenSlots{0};
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	int32 MaxSlots{0};
+
+private:
+
+	FSessionResultHandle Handle;
+};
+
+/**
+ * @brief Row widget of the session browser. The list view only creates the rows on screen and reuses them while scrolling.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UW_SessionBrowserEntry : public UUserWidget, public IUserObjectListEntry
+{
+	GENERATED_BODY()
+
+protected:
+
+	virtual void NativeOnListItemObjectSet(UObject* ListItemObject) override;
+
+private:
+
+	UPROPERTY(meta = (BindWidget))
+	class UTextBlock* OwningUserNameText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* MatchTypeText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* PlayersText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* PingText;
+};
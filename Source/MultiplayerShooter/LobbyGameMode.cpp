@@ -2,44 +2,146 @@
 
 
 #include "LobbyGameMode.h"
+#include "MultiplayerShooter.h"
 #include "GameFramework/PlayerState.h"
 #include "GameFramework/GameState.h"
+#include "Engine/GameInstance.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "EngineUtils.h"
+#include "LobbyGameState.h"
+#include "LobbyPlayerState.h"
+
+ALobbyGameMode::ALobbyGameMode()
+{
+    // Travel to the match without disconnecting the clients, and into the preloaded map
+    bUseSeamlessTravel = true;
+
+    GameStateClass = ALobbyGameState::StaticClass();
+    PlayerStateClass = ALobbyPlayerState::StaticClass();
+}
+
+void ALobbyGameMode::BeginPlay()
+{
+    Super::BeginPlay();
+
+    UGameInstance* GameInstance = GetGameInstance();
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if(Subsystem && !MatchMap.IsNull())
+    {
+        // Loads while the lobby fills
+        Subsystem->PreloadMap(MatchMap.GetLongPackageName());
+    }
+    if(Subsystem)
+    {
+        // Joining players reserve their slot first, if the reservations are on
+        Subsystem->StartReservationHost();
+    }
+}
 
 void ALobbyGameMode::PostLogin(APlayerController* NewPlayer)
 {
     Super::PostLogin(NewPlayer);
-    if(GameState)
+
+    // Dedicated servers have no local player in the session, the server registers the players itself
+    UGameInstance* GameInstance = GetGameInstance();
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if(Subsystem && NewPlayer->PlayerState)
     {
-        // To access to a TObjectPtr like this variable GameState, we need to call Get() function.
-        int32 NumberOfPlayer = GameState.Get()->PlayerArray.Num();
-        // The key "1" (first param) replace a text with the same value on the screen
-        if(GEngine){GEngine->AddOnScreenDebugMessage(1, 3, FColor::Blue, FString::Printf(TEXT("Number of players in the map : %d"), NumberOfPlayer));}
+        Subsystem->RegisterPlayer(NewPlayer->PlayerState->GetUniqueId());
+    }
 
-        // Get player name
-        APlayerState* PlayerState = NewPlayer->GetPlayerState<APlayerState>();
-        if(PlayerState)
+    ALobbyGameState* LobbyGameState = GetGameState<ALobbyGameState>();
+    if(LobbyGameState)
+    {
+        // Replicated to the clients with the next net update of the game state, together with the other changes of the frame
+        LobbyGameState->AddRosterPlayer(NewPlayer->GetPlayerState<APlayerState>());
+
+        if(LobbyGameState->GetRoster().Num() >= NumPlayersToStart)
         {
-            if(GEngine){GEngine->AddOnScreenDebugMessage(1, 3, FColor::Blue, FString::Printf(TEXT("%s has joinded the game !"), *PlayerState->GetPlayerName()));}
+            StartMatch();
         }
     }
 }
 
+void ALobbyGameMode::GetSeamlessTravelActorList(bool bToTransition, TArray<AActor*>& ActorList)
+{
+    // Game state, player states and controllers
+    Super::GetSeamlessTravelActorList(bToTransition, ActorList);
+
+    if(PersistentActorTag.IsNone())
+    {
+        return;
+    }
+    for(TActorIterator<AActor> It(GetWorld()); It; ++It)
+    {
+        if(It->ActorHasTag(PersistentActorTag))
+        {
+            ActorList.AddUnique(*It);
+        }
+    }
+}
+
+/**
+ * @brief Mark the session as in progress, then travel when the backend answers.
+ */
+void ALobbyGameMode::StartMatch()
+{
+    if(bIsStartingMatch || MatchMap.IsNull())
+    {
+        return;
+    }
+    bIsStartingMatch = true;
+
+    UGameInstance* GameInstance = GetGameInstance();
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if(!Subsystem)
+    {
+        OnSessionStarted(false);
+        return;
+    }
+
+    Subsystem->CustomOnStartSessionCompleteDelegate.AddDynamic(this, &ThisClass::OnSessionStarted);
+    Subsystem->StartSession();
+}
+
+void ALobbyGameMode::OnSessionStarted(bool bWasSuccessful)
+{
+    UGameInstance* GameInstance = GetGameInstance();
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if(Subsystem)
+    {
+        Subsystem->CustomOnStartSessionCompleteDelegate.RemoveDynamic(this, &ThisClass::OnSessionStarted);
+        Subsystem->StopReservationHost();
+    }
+
+    // Not fatal: the session keeps being advertised as pending, the match is played all the same
+    if(!bWasSuccessful)
+    {
+        UE_LOG(LogMultiplayerShooter, Warning, TEXT("Lobby: the session could not be started, travelling anyway."));
+    }
+
+    UWorld* World = GetWorld();
+    if(!World || !World->ServerTravel(FString::Printf(TEXT("%s?listen"), *MatchMap.GetLongPackageName())))
+    {
+        bIsStartingMatch = false;
+    }
+}
+
 
 void ALobbyGameMode::Logout(AController* Exiting)
 {
-    Super::Logout(Exiting);
-    if(GameState)
+    ALobbyGameState* LobbyGameState = GetGameState<ALobbyGameState>();
+    if(LobbyGameState && Exiting)
     {
-        // To access to a TObjectPtr like this variable GameState, we need to call Get() function.
-        int32 NumberOfPlayer = GameState.Get()->PlayerArray.Num();
-        // The key "1" (first param) replace a text with the same value on the screen
-        if(GEngine){GEngine->AddOnScreenDebugMessage(1, 3, FColor::Blue, FString::Printf(TEXT("Number of players in the map : %d"), NumberOfPlayer - 1));}
+        LobbyGameState->RemoveRosterPlayer(Exiting->GetPlayerState<APlayerState>());
+    }
 
-        // Get player name
-        APlayerState* PlayerState = Exiting->GetPlayerState<APlayerState>();
-        if(PlayerState)
-        {
-            if(GEngine){GEngine->AddOnScreenDebugMessage(1, 3, FColor::Blue, FString::Printf(TEXT("%s has leaved the game !"), *PlayerState->GetPlayerName()));}
-        }
+    UGameInstance* GameInstance = GetGameInstance();
+    UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+    if(Subsystem && Exiting && Exiting->PlayerState)
+    {
+        Subsystem->UnregisterPlayer(Exiting->PlayerState->GetUniqueId());
+        Subsystem->ReleaseReservation(Exiting->PlayerState->GetUniqueId());
     }
-}
\ No newline at end of file
+    Super::Logout(Exiting);
+}
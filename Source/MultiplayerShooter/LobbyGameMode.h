@@ -7,15 +7,44 @@
 #include "LobbyGameMode.generated.h"
 
 /**
- * 
+ * Waits for enough players in the lobby, then starts the session and travels everyone to the match.
+ * The match map is loaded in the background while the lobby fills, so the seamless travel doesn't wait for it.
  */
-UCLASS()
+UCLASS(Config = Game)
 class MULTIPLAYERSHOOTER_API ALobbyGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
+	ALobbyGameMode();
+
 	virtual void PostLogin(APlayerController* NewPlayer) override;
 	virtual void Logout(AController* Exiting) override;
-	
+
+	/**
+	 * Actors kept by the seamless travel to the match, on top of the controllers and player states the engine keeps.
+	 */
+	virtual void GetSeamlessTravelActorList(bool bToTransition, TArray<AActor*>& ActorList) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	// Players in the lobby needed to start the match
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Lobby", meta = (ClampMin = "1"))
+	int32 NumPlayersToStart{2};
+
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Lobby")
+	TSoftObjectPtr<UWorld> MatchMap;
+
+	// Actors with this tag travel to the match with the players, e.g. what they picked in the lobby
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Lobby")
+	FName PersistentActorTag{TEXT("PersistAcrossTravel")};
+
+private:
+	void StartMatch();
+
+	UFUNCTION()
+	void OnSessionStarted(bool bWasSuccessful);
+
+	bool bIsStartingMatch{false};
 };
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyGameState.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
+
+void FLobbyRoster::PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters)
+{
+    // Once per received delta, however many players joined, left or got ready in it
+    if(Owner)
+    {
+        Owner->OnRosterChanged.Broadcast();
+    }
+}
+
+ALobbyGameState::ALobbyGameState()
+{
+    Roster.Owner = this;
+}
+
+void ALobbyGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+    DOREPLIFETIME(ALobbyGameState, Roster);
+}
+
+FLobbyRosterEntry* ALobbyGameState::FindEntry(const APlayerState* PlayerState)
+{
+    if(!PlayerState)
+    {
+        return nullptr;
+    }
+    const int32 PlayerId = PlayerState->GetPlayerId();
+    return Roster.Entries.FindByPredicate([PlayerId](const FLobbyRosterEntry& Entry)
+    {
+        return Entry.PlayerId == PlayerId;
+    });
+}
+
+void ALobbyGameState::AddRosterPlayer(const APlayerState* PlayerState)
+{
+    if(!HasAuthority() || !PlayerState || FindEntry(PlayerState))
+    {
+        return;
+    }
+
+    // Lowest free slot, slots of the players who left are reused
+    int32 Slot = 0;
+    while(Roster.Entries.ContainsByPredicate([Slot](const FLobbyRosterEntry& Entry){ return Entry.Slot == Slot; }))
+    {
+        ++Slot;
+    }
+
+    FLobbyRosterEntry& Entry = Roster.Entries.AddDefaulted_GetRef();
+    Entry.PlayerId = PlayerState->GetPlayerId();
+    Entry.PlayerName = PlayerState->GetPlayerName();
+    Entry.Slot = Slot;
+    Roster.MarkItemDirty(Entry);
+    OnRosterChanged.Broadcast();
+}
+
+void ALobbyGameState::RemoveRosterPlayer(const APlayerState* PlayerState)
+{
+    if(!HasAuthority() || !PlayerState)
+    {
+        return;
+    }
+
+    const int32 PlayerId = PlayerState->GetPlayerId();
+    const int32 NumRemoved = Roster.Entries.RemoveAll([PlayerId](const FLobbyRosterEntry& Entry)
+    {
+        return Entry.PlayerId == PlayerId;
+    });
+    if(NumRemoved > 0)
+    {
+        // Only the removal is sent, the other entries keep their replication keys
+        Roster.MarkArrayDirty();
+        OnRosterChanged.Broadcast();
+    }
+}
+
+void ALobbyGameState::SetRosterPlayerReady(const APlayerState* PlayerState, bool bIsReady)
+{
+    FLobbyRosterEntry* Entry = HasAuthority() ? FindEntry(PlayerState) : nullptr;
+    if(!Entry || Entry->bIsReady == bIsReady)
+    {
+        return;
+    }
+    Entry->bIsReady = bIsReady;
+    Roster.MarkItemDirty(*Entry);
+    OnRosterChanged.Broadcast();
+}
+
+void ALobbyGameState::SetRosterPlayerName(const APlayerState* PlayerState)
+{
+    FLobbyRosterEntry* Entry = HasAuthority() ? FindEntry(PlayerState) : nullptr;
+    if(!Entry || Entry->PlayerName == PlayerState->GetPlayerName())
+    {
+        return;
+    }
+    Entry->PlayerName = PlayerState->GetPlayerName();
+    Roster.MarkItemDirty(*Entry);
+    OnRosterChanged.Broadcast();
+}
+
+int32 ALobbyGameState::GetNumReadyPlayers() const
+{
+    int32 NumReady = 0;
+    for(const FLobbyRosterEntry& Entry : Roster.Entries)
+    {
+        NumReady += Entry.bIsReady ? 1 : 0;
+    }
+    return NumReady;
+}
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "LobbyGameState.generated.h"
+
+class ALobbyGameState;
+
+/**
+ * A player of the lobby, as the clients see it.
+ */
+USTRUCT(BlueprintType)
+struct FLobbyRosterEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	// Id of the player state on the server, to find the entry again
+	UPROPERTY()
+	int32 PlayerId{INDEX_NONE};
+
+	UPROPERTY(BlueprintReadOnly, Category = "Lobby")
+	FString PlayerName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Lobby")
+	bool bIsReady{false};
+
+	UPROPERTY(BlueprintReadOnly, Category = "Lobby")
+	int32 Slot{INDEX_NONE};
+};
+
+/**
+ * Players of the lobby. Only the added, changed and removed entries are sent, and the changes made between two net updates
+ * of the game state go out together: the bandwidth follows the players joining, leaving and getting ready, not the lobby size.
+ */
+USTRUCT()
+struct FLobbyRoster : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FLobbyRosterEntry> Entries;
+
+	// Not replicated, for the client callback
+	UPROPERTY(NotReplicated)
+	TObjectPtr<ALobbyGameState> Owner;
+
+	// Client only: called by the fast array once a delta is applied, whatever it added, changed or removed
+	void PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FLobbyRosterEntry, FLobbyRoster>(Entries, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FLobbyRoster> : public TStructOpsTypeTraitsBase2<FLobbyRoster>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+DECLARE_MULTICAST_DELEGATE(FOnLobbyRosterChanged);
+
+/**
+ * Game state of the lobby, replicates the roster.
+ */
+UCLASS()
+class MULTIPLAYERSHOOTER_API ALobbyGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	ALobbyGameState();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/**
+	 * Server only. The player takes the lowest free slot.
+	 */
+	void AddRosterPlayer(const APlayerState* PlayerState);
+	void RemoveRosterPlayer(const APlayerState* PlayerState);
+	void SetRosterPlayerReady(const APlayerState* PlayerState, bool bIsReady);
+	void SetRosterPlayerName(const APlayerState* PlayerState);
+
+	const TArray<FLobbyRosterEntry>& GetRoster() const { return Roster.Entries; }
+	int32 GetNumReadyPlayers() const;
+
+	// Broadcast on the server and the clients when entries were added, changed or removed
+	FOnLobbyRosterChanged OnRosterChanged;
+
+private:
+	FLobbyRosterEntry* FindEntry(const APlayerState* PlayerState);
+
+	UPROPERTY(Replicated)
+	FLobbyRoster Roster;
+};
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyPlayerState.h"
+#include "LobbyGameState.h"
+#include "Engine/World.h"
+
+void ALobbyPlayerState::ServerSetReady_Implementation(bool bIsReady)
+{
+    ALobbyGameState* LobbyGameState = GetWorld() ? GetWorld()->GetGameState<ALobbyGameState>() : nullptr;
+    if(LobbyGameState)
+    {
+        LobbyGameState->SetRosterPlayerReady(this, bIsReady);
+    }
+}
+
+void ALobbyPlayerState::SetPlayerName(const FString& S)
+{
+    Super::SetPlayerName(S);
+
+    // The online name often arrives after PostLogin
+    ALobbyGameState* LobbyGameState = GetWorld() ? GetWorld()->GetGameState<ALobbyGameState>() : nullptr;
+    if(LobbyGameState)
+    {
+        LobbyGameState->SetRosterPlayerName(this);
+    }
+}
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerState.h"
+#include "LobbyPlayerState.generated.h"
+
+/**
+ * Player state of the lobby, lets the owning client tell the server it is ready.
+ */
+UCLASS()
+class MULTIPLAYERSHOOTER_API ALobbyPlayerState : public APlayerState
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Server, Reliable, Category = "Lobby")
+	void ServerSetReady(bool bIsReady);
+
+	virtual void SetPlayerName(const FString& S) override;
+};
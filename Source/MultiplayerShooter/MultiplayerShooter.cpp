@@ -1,7 +1,34 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "MultiplayerShooter.h"
+#include "MultiplayerShooterReplicationGraph.h"
 #include "Modules/ModuleManager.h"
+#include "Engine/NetDriver.h"
+#include "Engine/ReplicationDriver.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, MultiplayerShooter, "MultiplayerShooter" );
- 
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogMultiplayerShooter);
+
+class FMultiplayerShooterModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Only the game net driver, the beacons and the replays keep the default relevancy.
+		// It is created when the lobby starts listening, and the seamless travel keeps it for the match.
+		UReplicationDriver::CreateReplicationDriverDelegate().BindLambda([](UNetDriver* ForNetDriver, const FURL& URL, UWorld* World) -> UReplicationDriver*
+		{
+			if (!ForNetDriver || ForNetDriver->NetDriverName != NAME_GameNetDriver || !UMultiplayerShooterReplicationGraph::IsEnabled())
+			{
+				return nullptr;
+			}
+			return NewObject<UMultiplayerShooterReplicationGraph>(GetTransientPackage());
+		});
+	}
+
+	virtual void ShutdownModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FMultiplayerShooterModule, MultiplayerShooter, "MultiplayerShooter" );
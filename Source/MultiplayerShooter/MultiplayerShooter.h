@@ -3,3 +3,6 @@
 #pragma once
 
 #include "CoreMinimal.h"
+
+// Log category of the game module, the session plugin logs to LogMultiplayerSessions
+DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerShooter, Log, All);
@@ -8,6 +8,8 @@
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
 #include "OnlineSubsystem.h"
 #include "OnlineSessionSettings.h"
 
@@ -216,6 +218,79 @@ void AMultiplayerShooterCharacter::OnJoinSessionComplete(FName SessionName, EOnJ
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// Replication
+
+void AMultiplayerShooterCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Idle pawns only matter where they are replicated from
+	if (HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		LastMoveTime = GetWorld()->GetTimeSeconds();
+		OnCharacterMovementUpdated.AddDynamic(this, &ThisClass::OnCharacterMoved);
+		GetWorldTimerManager().SetTimer(IdleTimerHandle, this, &ThisClass::CheckIdle, IdleCheckInterval, true);
+	}
+}
+
+void AMultiplayerShooterCharacter::OnCharacterMoved(float DeltaSeconds, FVector OldLocation, FVector OldVelocity)
+{
+	if (GetVelocity().IsNearlyZero() && GetActorLocation().Equals(OldLocation))
+	{
+		return;
+	}
+
+	LastMoveTime = GetWorld()->GetTimeSeconds();
+	if (bIsIdle)
+	{
+		WakeUp();
+	}
+}
+
+void AMultiplayerShooterCharacter::CheckIdle()
+{
+	if (!bIsIdle && GetWorld()->GetTimeSeconds() - LastMoveTime >= IdleDelay)
+	{
+		bIsIdle = true;
+	}
+
+	// Also catches a pawn its player left while it was already idle
+	if (bIsIdle && bDormantWhenIdle && !IsPlayerControlled() && NetDormancy == DORM_Awake)
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void AMultiplayerShooterCharacter::WakeUp()
+{
+	bIsIdle = false;
+	if (NetDormancy > DORM_Awake)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+	else
+	{
+		// The replication graph sends idle pawns less often, the first move goes out with the next net update
+		ForceNetUpdate();
+	}
+}
+
+void AMultiplayerShooterCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	// A dormant pawn has no channel for its new player's moves
+	if (HasAuthority())
+	{
+		LastMoveTime = GetWorld()->GetTimeSeconds();
+		if (bIsIdle || NetDormancy > DORM_Awake)
+		{
+			WakeUp();
+		}
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -55,14 +55,32 @@ protected:
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+	virtual void PossessedBy(AController* NewController) override;
 	// End of APawn interface
 
+	virtual void BeginPlay() override;
+
+	// Seconds without moving before the pawn is idle, and the replication graph sends it less often to the other players
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Replication", meta = (ClampMin = "0"))
+	float IdleDelay{5.f};
+
+	// Idle pawns no player controls go dormant. A player's pawn never does: its channel carries its owner's moves
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Replication")
+	bool bDormantWhenIdle{true};
+
+	// How often the server checks whether the pawn became idle
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Replication", meta = (ClampMin = "0.1"))
+	float IdleCheckInterval{1.f};
+
 public:
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
+	/** Whether the pawn hasn't moved for IdleDelay seconds. Only tracked by the server **/
+	FORCEINLINE bool IsIdle() const { return bIsIdle; }
+
 	// LAN
 
 	UFUNCTION(BlueprintCallable)
@@ -91,6 +109,16 @@ public: // ONLINE SESSIONS
 
 private:
 
+	/** Server only: what moves the pawn wakes it up */
+	UFUNCTION()
+	void OnCharacterMoved(float DeltaSeconds, FVector OldLocation, FVector OldVelocity);
+	void CheckIdle();
+	void WakeUp();
+
+	double LastMoveTime{0.0};
+	bool bIsIdle{false};
+	FTimerHandle IdleTimerHandle;
+
 	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
 	FOnFindSessionsCompleteDelegate FindSessionsCompleteDelegate;
 	FOnJoinSessionCompleteDelegate JoinSessionCompleteDelegate;
@@ -3,6 +3,9 @@
 #include "MultiplayerShooterGameMode.h"
 #include "MultiplayerShooterCharacter.h"
 #include "UObject/ConstructorHelpers.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/PlayerState.h"
+#include "MultiplayerSessionsSubsystem.h"
 
 AMultiplayerShooterGameMode::AMultiplayerShooterGameMode()
 {
@@ -12,4 +15,31 @@ AMultiplayerShooterGameMode::AMultiplayerShooterGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	// Back to the lobby without disconnecting the clients
+	bUseSeamlessTravel = true;
+}
+
+void AMultiplayerShooterGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+	if (Subsystem && NewPlayer->PlayerState)
+	{
+		Subsystem->RegisterPlayer(NewPlayer->PlayerState->GetUniqueId());
+	}
+}
+
+void AMultiplayerShooterGameMode::Logout(AController* Exiting)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+	if (Subsystem && Exiting && Exiting->PlayerState)
+	{
+		Subsystem->UnregisterPlayer(Exiting->PlayerState->GetUniqueId());
+	}
+
+	Super::Logout(Exiting);
 }
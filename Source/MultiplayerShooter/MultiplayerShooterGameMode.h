@@ -13,6 +13,10 @@ class AMultiplayerShooterGameMode : public AGameModeBase
 
 public:
 	AMultiplayerShooterGameMode();
+
+	// Keep the free slots of the session right when players join or leave during the match
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void Logout(AController* Exiting) override;
 };
 
 
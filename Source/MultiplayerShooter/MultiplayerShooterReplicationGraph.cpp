@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerShooterReplicationGraph.h"
+#include "MultiplayerShooterCharacter.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/PlayerState.h"
+#include "UObject/UObjectIterator.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+UMultiplayerShooterReplicationGraph::UMultiplayerShooterReplicationGraph()
+    : CellSize(10000.f)
+    , PawnCullDistance(15000.f)
+    , NumFrequencyBuckets(3)
+    , FrequencyBucketListSize(12)
+    , PlayerStatesPerFrame(2)
+    , PawnBucketDistances({3000.f, 7500.f})
+    , IdlePawnReplicationPeriod(8)
+    , ConnectionsToRebucketPerFrame(8)
+{
+}
+
+bool UMultiplayerShooterReplicationGraph::IsEnabled()
+{
+    return !FParse::Param(FCommandLine::Get(), TEXT("NoReplicationGraph"));
+}
+
+uint16 UMultiplayerShooterReplicationGraph::GetReplicationPeriodFrame(float NetUpdateFrequency) const
+{
+    // The graph counts in frames of the server, not in seconds
+    const float MaxTickRate = NetDriver ? static_cast<float>(NetDriver->GetNetServerMaxTickRate()) : 30.f;
+    const float Frequency = FMath::Max(NetUpdateFrequency, UE_KINDA_SMALL_NUMBER);
+    return static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(MaxTickRate / Frequency), 1, static_cast<int32>(MAX_uint16)));
+}
+
+void UMultiplayerShooterReplicationGraph::InitGlobalActorClassSettings()
+{
+    // Rates and cull distances of every replicated class, from their defaults
+    Super::InitGlobalActorClassSettings();
+
+    // The blueprints of the character are loaded by now, the ones loaded later get the settings of their native parent
+    for(TObjectIterator<UClass> It; It; ++It)
+    {
+        UClass* Class = *It;
+        if(!Class->IsChildOf(AMultiplayerShooterCharacter::StaticClass()) || Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+        {
+            continue;
+        }
+
+        const AActor* ActorCDO = GetDefault<AActor>(Class);
+        FClassReplicationInfo PawnInfo;
+        PawnInfo.ReplicationPeriodFrame = GetReplicationPeriodFrame(ActorCDO->NetUpdateFrequency);
+        PawnInfo.SetCullDistanceSquared(FMath::Square(PawnCullDistance));
+        GlobalActorReplicationInfoMap.SetClassInfo(Class, PawnInfo);
+    }
+}
+
+void UMultiplayerShooterReplicationGraph::InitGlobalGraphNodes()
+{
+    // Replaces the nodes of UBasicReplicationGraph, so its grid settings come from the config
+    UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.NumBuckets = FMath::Max(NumFrequencyBuckets, 1);
+    UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.ListSize = FMath::Max(FrequencyBucketListSize, 1);
+
+    GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+    GridNode->CellSize = CellSize;
+    GridNode->SpatialBias = FVector2D(-UE_OLD_WORLD_MAX, -UE_OLD_WORLD_MAX);
+    AddGlobalGraphNode(GridNode);
+
+    AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+    AddGlobalGraphNode(AlwaysRelevantNode);
+
+    PlayerStateNode = CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>();
+    PlayerStateNode->TargetActorsPerFrame = FMath::Max(PlayerStatesPerFrame, 1);
+    AddGlobalGraphNode(PlayerStateNode);
+}
+
+void UMultiplayerShooterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+    // The limiter node gathers the player states by itself
+    if(ActorInfo.Actor->IsA<APlayerState>())
+    {
+        return;
+    }
+
+    // Always relevant list, owner's connection, or the grid
+    Super::RouteAddNetworkActorToNodes(ActorInfo, GlobalInfo);
+
+    if(AMultiplayerShooterCharacter* Pawn = Cast<AMultiplayerShooterCharacter>(ActorInfo.Actor))
+    {
+        Pawns.Add(Pawn);
+    }
+}
+
+void UMultiplayerShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+    if(ActorInfo.Actor->IsA<APlayerState>())
+    {
+        // Player states sit at the origin, every connection must hear of their destruction
+        SetActorDestructionInfoToIgnoreDistanceCulling(ActorInfo.GetActor());
+        return;
+    }
+
+    Super::RouteRemoveNetworkActorToNodes(ActorInfo);
+
+    if(AMultiplayerShooterCharacter* Pawn = Cast<AMultiplayerShooterCharacter>(ActorInfo.Actor))
+    {
+        Pawns.RemoveSingleSwap(Pawn);
+    }
+}
+
+int32 UMultiplayerShooterReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+    // A few connections per frame, so the cost doesn't grow with connections x pawns each frame
+    const int32 NumConnections = Connections.Num();
+    const int32 NumToRebucket = FMath::Min(ConnectionsToRebucketPerFrame, NumConnections);
+    for(int32 Count = 0; Count < NumToRebucket; ++Count)
+    {
+        // Connections come and go between two frames
+        NextConnectionToRebucket %= NumConnections;
+        UpdatePawnBuckets(Connections[NextConnectionToRebucket++]);
+    }
+
+    return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+void UMultiplayerShooterReplicationGraph::UpdatePawnBuckets(UNetReplicationGraphConnection* GraphConnection)
+{
+    UNetConnection* NetConnection = GraphConnection ? GraphConnection->NetConnection.Get() : nullptr;
+    const AActor* ViewTarget = NetConnection ? NetConnection->ViewTarget.Get() : nullptr;
+    if(!ViewTarget)
+    {
+        return;
+    }
+    const FVector ViewLocation = ViewTarget->GetActorLocation();
+
+    for(AMultiplayerShooterCharacter* Pawn : Pawns)
+    {
+        // Not replicated to that connection yet, it gets the class rate until its next turn
+        FConnectionReplicationActorInfo* ActorInfo = GraphConnection->ActorInfoMap.Find(Pawn);
+        if(!ActorInfo)
+        {
+            continue;
+        }
+
+        const uint16 ClassPeriod = static_cast<uint16>(GlobalActorReplicationInfoMap.Get(Pawn).Settings.ReplicationPeriodFrame);
+
+        // The owner plays the pawn, it always gets it at the class rate
+        if(Pawn->GetNetConnection() == NetConnection)
+        {
+            ActorInfo->ReplicationPeriodFrame = ClassPeriod;
+            continue;
+        }
+
+        const double DistanceSquared = FVector::DistSquared(ViewLocation, Pawn->GetActorLocation());
+        int32 Bucket = 0;
+        while(Bucket < PawnBucketDistances.Num() && DistanceSquared > FMath::Square(PawnBucketDistances[Bucket]))
+        {
+            ++Bucket;
+        }
+
+        uint32 Period = static_cast<uint32>(ClassPeriod) << Bucket;
+        if(Pawn->IsIdle())
+        {
+            // Waking up forces a net update, the first move isn't held back by the idle period
+            Period = FMath::Max(Period, static_cast<uint32>(IdlePawnReplicationPeriod));
+        }
+        ActorInfo->ReplicationPeriodFrame = static_cast<uint16>(FMath::Min<uint32>(Period, MAX_uint16));
+    }
+}
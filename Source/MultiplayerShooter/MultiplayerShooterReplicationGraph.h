@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BasicReplicationGraph.h"
+#include "MultiplayerShooterReplicationGraph.generated.h"
+
+class AMultiplayerShooterCharacter;
+class UReplicationGraphNode_PlayerStateFrequencyLimiter;
+
+/**
+ * Replication graph of the game net driver, used in the lobby and kept by the seamless travel to the match.
+ * Without it, each net tick tests every replicated actor against every connection. With it:
+ * - The pawns sit in a 2D spatial grid, a connection only gathers the cells around its view target.
+ *   Dormant pawns are static in the grid and cost nothing until they wake up.
+ * - A grid cell with many moving actors spreads them over frequency buckets, one bucket per frame.
+ * - Each connection gets the pawns around it every frame and the far ones every 2, 4... frames,
+ *   and the idle pawns of other players every IdlePawnReplicationPeriod frames.
+ * - The player states are sent a few per frame instead of all of them every frame.
+ *
+ * Started with -NoReplicationGraph, the server keeps the default relevancy, to compare.
+ */
+UCLASS(Transient, Config = Engine)
+class MULTIPLAYERSHOOTER_API UMultiplayerShooterReplicationGraph : public UBasicReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UMultiplayerShooterReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/**
+	 * Whether the game net driver gets the graph, i.e. the server wasn't started with -NoReplicationGraph.
+	 */
+	static bool IsEnabled();
+
+protected:
+	// Side of a cell of the spatial grid, in cm
+	UPROPERTY(Config)
+	float CellSize;
+
+	// Pawns farther than that from the view target of a connection aren't relevant to it, in cm
+	UPROPERTY(Config)
+	float PawnCullDistance;
+
+	// Past FrequencyBucketListSize moving actors, a grid cell sends them over that many frames
+	UPROPERTY(Config)
+	int32 NumFrequencyBuckets;
+
+	UPROPERTY(Config)
+	int32 FrequencyBucketListSize;
+
+	// Player states sent per frame, each one is sent every NumPlayers / PlayerStatesPerFrame frames
+	UPROPERTY(Config)
+	int32 PlayerStatesPerFrame;
+
+	// Distances of the pawn buckets of a connection, in cm, ascending. A pawn past N of them is sent every 2^N times its rate
+	UPROPERTY(Config)
+	TArray<float> PawnBucketDistances;
+
+	// Frames between two sends of an idle pawn to the other players, its owner still gets it at its rate
+	UPROPERTY(Config)
+	int32 IdlePawnReplicationPeriod;
+
+	// Connections whose pawn buckets are recomputed each frame, the others keep theirs until their turn
+	UPROPERTY(Config)
+	int32 ConnectionsToRebucketPerFrame;
+
+private:
+	/**
+	 * Set how often each pawn is sent to that connection, from its distance to the connection's view target and whether it is idle.
+	 */
+	void UpdatePawnBuckets(UNetReplicationGraphConnection* GraphConnection);
+
+	uint16 GetReplicationPeriodFrame(float NetUpdateFrequency) const;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_PlayerStateFrequencyLimiter> PlayerStateNode;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AMultiplayerShooterCharacter>> Pawns;
+
+	int32 NextConnectionToRebucket{0};
+};
@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetTickBenchmark.h"
+#include "MultiplayerShooterReplicationGraph.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "EngineUtils.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+
+DEFINE_LOG_CATEGORY(LogNetTickBenchmark);
+
+bool UNetTickBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+    const TCHAR* CommandLine = FCommandLine::Get();
+    return Super::ShouldCreateSubsystem(Outer) && (FParse::Param(CommandLine, TEXT("NetTickBenchmark")) || FParse::Param(CommandLine, TEXT("SimulatedClient")));
+}
+
+bool UNetTickBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UNetTickBenchmarkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    const TCHAR* CommandLine = FCommandLine::Get();
+    const ENetMode NetMode = InWorld.GetNetMode();
+    if(NetMode == NM_Client)
+    {
+        bIsSimulatedClient = FParse::Param(CommandLine, TEXT("SimulatedClient"));
+        FParse::Value(CommandLine, TEXT("IdleFraction="), IdleFraction);
+        // Every client process walks its own way
+        Random.Initialize(static_cast<int32>(FPlatformProcess::GetCurrentProcessId()));
+        return;
+    }
+
+    if(NetMode == NM_Standalone || !FParse::Param(CommandLine, TEXT("NetTickBenchmark")))
+    {
+        return;
+    }
+
+    FParse::Value(CommandLine, TEXT("BenchmarkClients="), ExpectedClients);
+    FParse::Value(CommandLine, TEXT("BenchmarkWarmUp="), WarmUp);
+    FParse::Value(CommandLine, TEXT("BenchmarkDuration="), Duration);
+    FParse::Value(CommandLine, TEXT("BenchmarkClientTimeout="), ClientTimeout);
+    FParse::Value(CommandLine, TEXT("BenchmarkReport="), ReportPath);
+
+    PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::OnPostActorTick);
+    PostTickFlushHandle = InWorld.OnPostTickFlush().AddUObject(this, &ThisClass::OnPostTickFlush);
+
+    State = EBenchmarkState::WaitingForClients;
+    StateStartTime = FPlatformTime::Seconds();
+    UE_LOG(LogNetTickBenchmark, Display, TEXT("Net tick benchmark: waiting for %d clients on %s, replication graph %s."),
+        ExpectedClients, *InWorld.GetMapName(), UMultiplayerShooterReplicationGraph::IsEnabled() ? TEXT("on") : TEXT("off"));
+}
+
+void UNetTickBenchmarkSubsystem::Deinitialize()
+{
+    if(State == EBenchmarkState::WaitingForClients || State == EBenchmarkState::WarmingUp || State == EBenchmarkState::Sampling)
+    {
+        UE_LOG(LogNetTickBenchmark, Warning, TEXT("Net tick benchmark: the world went away before the end of the run."));
+    }
+
+    FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+    if(UWorld* World = GetWorld())
+    {
+        World->OnPostTickFlush().Remove(PostTickFlushHandle);
+    }
+    State = EBenchmarkState::Off;
+
+    Super::Deinitialize();
+}
+
+TStatId UNetTickBenchmarkSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UNetTickBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UNetTickBenchmarkSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if(bIsSimulatedClient)
+    {
+        TickSimulatedClient(DeltaTime);
+    }
+    else if(State != EBenchmarkState::Off)
+    {
+        TickServer();
+    }
+}
+
+void UNetTickBenchmarkSubsystem::TickServer()
+{
+    const double Now = FPlatformTime::Seconds();
+    switch(State)
+    {
+    case EBenchmarkState::WaitingForClients:
+    {
+        const int32 NumPlayers = GetNumPlayers();
+        const bool bTimedOut = Now - StateStartTime >= ClientTimeout;
+        if(NumPlayers < ExpectedClients && !bTimedOut)
+        {
+            break;
+        }
+        if(NumPlayers < ExpectedClients)
+        {
+            UE_LOG(LogNetTickBenchmark, Warning, TEXT("Net tick benchmark: %d of %d clients joined within %.0f s, measuring with them."), NumPlayers, ExpectedClients, ClientTimeout);
+        }
+        State = EBenchmarkState::WarmingUp;
+        StateStartTime = Now;
+        break;
+    }
+    case EBenchmarkState::WarmingUp:
+        // Past the logins, the initial replication of every actor to every client and the first dormancies
+        if(Now - StateStartTime >= WarmUp)
+        {
+            NetTickTimes.Reset();
+            TotalNetTime = 0.0;
+            NumFrames = 0;
+            NumClientsMeasured = GetNumPlayers();
+            NumPawnsMeasured = 0;
+            for(TActorIterator<APawn> It(GetWorld()); It; ++It)
+            {
+                ++NumPawnsMeasured;
+            }
+            State = EBenchmarkState::Sampling;
+            StateStartTime = Now;
+            UE_LOG(LogNetTickBenchmark, Display, TEXT("Net tick benchmark: measuring %d clients and %d pawns for %.0f s."), NumClientsMeasured, NumPawnsMeasured, Duration);
+        }
+        break;
+    case EBenchmarkState::Sampling:
+        if(Now - StateStartTime >= Duration)
+        {
+            Finish();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void UNetTickBenchmarkSubsystem::OnPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+    if(State == EBenchmarkState::Sampling && World == GetWorld())
+    {
+        NetTickStartTime = FPlatformTime::Seconds();
+    }
+}
+
+void UNetTickBenchmarkSubsystem::OnPostTickFlush(float DeltaSeconds)
+{
+    if(State != EBenchmarkState::Sampling || NetTickStartTime <= 0.0)
+    {
+        return;
+    }
+    const double Seconds = FPlatformTime::Seconds() - NetTickStartTime;
+    NetTickStartTime = 0.0;
+    NetTickTimes.AddSample(Seconds);
+    TotalNetTime += Seconds;
+    ++NumFrames;
+}
+
+const TCHAR* UNetTickBenchmarkSubsystem::GetReportHeader()
+{
+    return TEXT("Clients,Pawns,ReplicationGraph,Frames,MeanMs,P50Ms,P95Ms,P99Ms,MaxMs,FrameBudgetPct");
+}
+
+FString UNetTickBenchmarkSubsystem::GetReportLine() const
+{
+    const UWorld* World = GetWorld();
+    const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+    const bool bUsesGraph = NetDriver && Cast<UMultiplayerShooterReplicationGraph>(NetDriver->GetReplicationDriver()) != nullptr;
+    const double FrameBudget = 1.0 / FMath::Max(NetDriver ? NetDriver->GetNetServerMaxTickRate() : 30, 1);
+
+    double P50, P95, P99;
+    NetTickTimes.GetPercentiles(P50, P95, P99);
+    const double Mean = NumFrames > 0 ? TotalNetTime / NumFrames : 0.0;
+    return FString::Printf(TEXT("%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f"),
+        NumClientsMeasured, NumPawnsMeasured, bUsesGraph ? 1 : 0, NumFrames,
+        Mean * 1000.0, P50 * 1000.0, P95 * 1000.0, P99 * 1000.0, NetTickTimes.GetMax() * 1000.0,
+        Mean / FrameBudget * 100.0);
+}
+
+void UNetTickBenchmarkSubsystem::Finish()
+{
+    State = EBenchmarkState::Done;
+
+    const FString Line = GetReportLine();
+    UE_LOG(LogNetTickBenchmark, Display, TEXT("Net tick benchmark: %s"), GetReportHeader());
+    UE_LOG(LogNetTickBenchmark, Display, TEXT("Net tick benchmark: %s"), *Line);
+
+    if(!ReportPath.IsEmpty() && !FFileHelper::SaveStringToFile(FString::Printf(TEXT("%s\n%s\n"), GetReportHeader(), *Line), *ReportPath))
+    {
+        UE_LOG(LogNetTickBenchmark, Error, TEXT("Net tick benchmark: could not write %s."), *ReportPath);
+    }
+    FPlatformMisc::RequestExit(false);
+}
+
+int32 UNetTickBenchmarkSubsystem::GetNumPlayers() const
+{
+    const AGameStateBase* GameState = GetWorld() ? GetWorld()->GetGameState() : nullptr;
+    return GameState ? GameState->PlayerArray.Num() : 0;
+}
+
+void UNetTickBenchmarkSubsystem::TickSimulatedClient(float DeltaTime)
+{
+    APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+    APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+    if(!Pawn)
+    {
+        return;
+    }
+
+    TimeToNextMove -= DeltaTime;
+    if(TimeToNextMove <= 0.f)
+    {
+        TimeToNextMove = Random.FRandRange(2.f, 6.f);
+        MoveDirection = Random.FRand() < IdleFraction ? FVector::ZeroVector : FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f).Vector();
+    }
+
+    // Sent to the server by the character movement like a player's input
+    if(!MoveDirection.IsZero())
+    {
+        Pawn->AddMovementInput(MoveDirection);
+    }
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SessionLatencyStats.h"
+#include "NetTickBenchmark.generated.h"
+
+// Shared by the benchmark subsystem and the NetTickBenchmark commandlet
+DECLARE_LOG_CATEGORY_EXTERN(LogNetTickBenchmark, Log, All);
+
+/**
+ * The two ends of the NetTickBenchmark commandlet, off unless the process is started with one of these switches:
+ * -NetTickBenchmark (server): once -BenchmarkClients=N players are in, and after -BenchmarkWarmUp=5 seconds, measures the net tick
+ *   of each frame for -BenchmarkDuration=30 seconds, writes the result to -BenchmarkReport=<file> and exits.
+ *   The net tick is measured from the end of the actor tick to the end of the net driver's TickFlush: relevancy,
+ *   prioritization, replication and sends, the part the replication graph changes.
+ * -SimulatedClient (client): walks the local pawn in random directions, and stands still a share -IdleFraction=0.3 of the time.
+ */
+UCLASS()
+class MULTIPLAYERSHOOTER_API UNetTickBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Header of the report line, and the line itself.
+	 */
+	static const TCHAR* GetReportHeader();
+	FString GetReportLine() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class EBenchmarkState : uint8
+	{
+		Off,
+		WaitingForClients,
+		WarmingUp,
+		Sampling,
+		Done
+	};
+
+	void TickServer();
+	void TickSimulatedClient(float DeltaTime);
+
+	void OnPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush(float DeltaSeconds);
+	void Finish();
+
+	int32 GetNumPlayers() const;
+
+	EBenchmarkState State{EBenchmarkState::Off};
+	bool bIsSimulatedClient{false};
+
+	int32 ExpectedClients{16};
+	double WarmUp{5.0};
+	double Duration{30.0};
+	// Past that, the run starts with the clients that made it in
+	double ClientTimeout{180.0};
+	FString ReportPath;
+
+	double StateStartTime{0.0};
+	double NetTickStartTime{0.0};
+	double TotalNetTime{0.0};
+	int32 NumFrames{0};
+	int32 NumClientsMeasured{0};
+	int32 NumPawnsMeasured{0};
+	// Every frame of a run, 30 fps for half an hour
+	FSessionLatencyHistogram NetTickTimes{1 << 16};
+
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+
+	// Simulated client
+	FRandomStream Random;
+	FVector MoveDirection{FVector::ZeroVector};
+	float IdleFraction{0.3f};
+	float TimeToNextMove{0.f};
+};
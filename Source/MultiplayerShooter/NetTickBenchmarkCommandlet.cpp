@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetTickBenchmarkCommandlet.h"
+#include "NetTickBenchmark.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    // The server waits that long for its clients, then measures with the ones that made it in
+    constexpr double ClientJoinTimeout = 180.0;
+    // Left to the server past the end of its run to write its report and exit, before it is killed
+    constexpr double ServerExitMargin = 60.0;
+    // Between two client launches, so the logins don't all land in the same frame
+    constexpr float ClientLaunchInterval = 0.1f;
+
+    struct FBenchmarkParams
+    {
+        TArray<int32> ClientCounts{16, 64, 100};
+        double Duration{30.0};
+        double WarmUp{5.0};
+        FString Map{TEXT("/Game/ThirdPerson/Maps/Lobby")};
+        int32 Port{7777};
+        float IdleFraction{0.3f};
+        float ServerStartup{20.f};
+        bool bCompare{false};
+    };
+
+    FProcHandle Launch(const FString& _Args)
+    {
+        // This very editor binary runs the server with -server and the clients with -game
+        return FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *_Args, true, true, true, nullptr, 0, nullptr, nullptr);
+    }
+
+    void Stop(FProcHandle& _Process)
+    {
+        if(!_Process.IsValid())
+        {
+            return;
+        }
+        if(FPlatformProcess::IsProcRunning(_Process))
+        {
+            FPlatformProcess::TerminateProc(_Process, true);
+        }
+        FPlatformProcess::CloseProc(_Process);
+    }
+
+    /**
+     * @brief One server and _NumClients clients, until the server has written its report.
+     * @return false if the server didn't report.
+     */
+    bool Run(const FBenchmarkParams& _Params, int32 _NumClients, bool _bUseGraph, FString& OutReportLine)
+    {
+        const FString Mode = _bUseGraph ? TEXT("Graph") : TEXT("Default");
+        const FString ReportPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("NetTickBenchmark") / FString::Printf(TEXT("%d_%s.csv"), _NumClients, *Mode));
+        IFileManager::Get().Delete(*ReportPath, false, false, true);
+        const FString Project = FString::Printf(TEXT("\"%s\""), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()));
+
+        // The lobby must not start the match, and the session must take everyone. No Steam, many processes share this machine
+        const FString ServerArgs = FString::Printf(TEXT("%s %s -server -nullrhi -nosteam -unattended -Port=%d %s")
+            TEXT(" -NetTickBenchmark -BenchmarkClients=%d -BenchmarkWarmUp=%.1f -BenchmarkDuration=%.1f -BenchmarkClientTimeout=%.0f -BenchmarkReport=\"%s\"")
+            TEXT(" -ini:Game:[/Script/MultiplayerShooter.LobbyGameMode]:NumPlayersToStart=%d,[/Script/Engine.GameSession]:MaxPlayers=%d")
+            TEXT(" -LOG=NetTickBenchmark_%d_%s_Server.log"),
+            *Project, *_Params.Map, _Params.Port, _bUseGraph ? TEXT("") : TEXT("-NoReplicationGraph"),
+            _NumClients, _Params.WarmUp, _Params.Duration, ClientJoinTimeout, *ReportPath,
+            _NumClients + 1, _NumClients,
+            _NumClients, *Mode);
+
+        UE_LOG(LogNetTickBenchmark, Display, TEXT("%d clients, replication graph %s: starting the server."), _NumClients, _bUseGraph ? TEXT("on") : TEXT("off"));
+        FProcHandle Server = Launch(ServerArgs);
+        if(!Server.IsValid())
+        {
+            UE_LOG(LogNetTickBenchmark, Error, TEXT("Could not start the server."));
+            return false;
+        }
+        FPlatformProcess::Sleep(_Params.ServerStartup);
+
+        TArray<FProcHandle> Clients;
+        for(int32 ClientIndex = 0; ClientIndex < _NumClients && FPlatformProcess::IsProcRunning(Server); ++ClientIndex)
+        {
+            const FString ClientArgs = FString::Printf(TEXT("%s 127.0.0.1:%d -game -nullrhi -nosound -nosteam -unattended -SimulatedClient -IdleFraction=%.2f -LOG=NetTickBenchmark_%d_%s_Client%d.log"),
+                *Project, _Params.Port, _Params.IdleFraction, _NumClients, *Mode, ClientIndex);
+            FProcHandle Client = Launch(ClientArgs);
+            if(!Client.IsValid())
+            {
+                UE_LOG(LogNetTickBenchmark, Warning, TEXT("Could not start client %d."), ClientIndex);
+                continue;
+            }
+            Clients.Add(Client);
+            FPlatformProcess::Sleep(ClientLaunchInterval);
+        }
+        UE_LOG(LogNetTickBenchmark, Display, TEXT("%d clients started, the server measures once they are in."), Clients.Num());
+
+        // The server exits by itself once it has reported
+        const double Deadline = FPlatformTime::Seconds() + ClientJoinTimeout + _Params.WarmUp + _Params.Duration + ServerExitMargin;
+        while(FPlatformProcess::IsProcRunning(Server) && FPlatformTime::Seconds() < Deadline && !IsEngineExitRequested())
+        {
+            FPlatformProcess::Sleep(1.f);
+        }
+
+        for(FProcHandle& Client : Clients)
+        {
+            Stop(Client);
+        }
+        Stop(Server);
+
+        TArray<FString> Lines;
+        if(!FFileHelper::LoadFileToStringArray(Lines, *ReportPath) || Lines.Num() < 2)
+        {
+            UE_LOG(LogNetTickBenchmark, Error, TEXT("The server didn't report, see its log NetTickBenchmark_%d_%s_Server.log."), _NumClients, *Mode);
+            return false;
+        }
+        OutReportLine = Lines[1];
+        return true;
+    }
+
+    void Report(const TArray<FString>& _ReportLines)
+    {
+        UE_LOG(LogNetTickBenchmark, Display, TEXT("Server net tick per frame:"));
+        UE_LOG(LogNetTickBenchmark, Display, TEXT("Clients  Pawns  Graph   Frames |     mean      p50      p95      p99      max (ms) | frame budget"));
+        for(const FString& Line : _ReportLines)
+        {
+            // Same columns as UNetTickBenchmarkSubsystem::GetReportHeader()
+            TArray<FString> Fields;
+            Line.ParseIntoArray(Fields, TEXT(","));
+            if(Fields.Num() != 10)
+            {
+                UE_LOG(LogNetTickBenchmark, Display, TEXT("%s"), *Line);
+                continue;
+            }
+            UE_LOG(LogNetTickBenchmark, Display, TEXT("%7s %6s %6s %8s | %8s %8s %8s %8s %8s      | %10s %%"),
+                *Fields[0], *Fields[1], Fields[2] == TEXT("1") ? TEXT("on") : TEXT("off"), *Fields[3],
+                *Fields[4], *Fields[5], *Fields[6], *Fields[7], *Fields[8], *Fields[9]);
+        }
+        UE_LOG(LogNetTickBenchmark, Display, TEXT("CSV: %s"), UNetTickBenchmarkSubsystem::GetReportHeader());
+        for(const FString& Line : _ReportLines)
+        {
+            UE_LOG(LogNetTickBenchmark, Display, TEXT("CSV: %s"), *Line);
+        }
+    }
+}
+
+UNetTickBenchmarkCommandlet::UNetTickBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UNetTickBenchmarkCommandlet::Main(const FString& Params)
+{
+    FBenchmarkParams BenchmarkParams;
+    FString ClientCounts;
+    if(FParse::Value(*Params, TEXT("Clients="), ClientCounts, false))
+    {
+        TArray<FString> Counts;
+        ClientCounts.ParseIntoArray(Counts, TEXT(","));
+        BenchmarkParams.ClientCounts.Reset();
+        for(const FString& Count : Counts)
+        {
+            BenchmarkParams.ClientCounts.Add(FMath::Max(FCString::Atoi(*Count), 1));
+        }
+    }
+    FParse::Value(*Params, TEXT("Duration="), BenchmarkParams.Duration);
+    FParse::Value(*Params, TEXT("WarmUp="), BenchmarkParams.WarmUp);
+    FParse::Value(*Params, TEXT("Map="), BenchmarkParams.Map);
+    FParse::Value(*Params, TEXT("Port="), BenchmarkParams.Port);
+    FParse::Value(*Params, TEXT("IdleFraction="), BenchmarkParams.IdleFraction);
+    FParse::Value(*Params, TEXT("ServerStartup="), BenchmarkParams.ServerStartup);
+    BenchmarkParams.bCompare = FParse::Param(*Params, TEXT("Compare"));
+
+    TArray<FString> ReportLines;
+    bool bAllReported = true;
+    for(int32 NumClients : BenchmarkParams.ClientCounts)
+    {
+        for(bool bUseGraph : {true, false})
+        {
+            if(!bUseGraph && !BenchmarkParams.bCompare)
+            {
+                continue;
+            }
+
+            FString ReportLine;
+            if(Run(BenchmarkParams, NumClients, bUseGraph, ReportLine))
+            {
+                ReportLines.Add(ReportLine);
+            }
+            else
+            {
+                bAllReported = false;
+            }
+
+            if(IsEngineExitRequested())
+            {
+                Report(ReportLines);
+                return 1;
+            }
+        }
+    }
+
+    Report(ReportLines);
+    return bAllReported ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "NetTickBenchmarkCommandlet.generated.h"
+
+/**
+ * Server CPU benchmark: for each client count, starts a dedicated server and that many headless simulated clients on this machine,
+ * lets the server measure its net tick once they are all in, and logs one line per run. See UNetTickBenchmarkSubsystem for both ends.
+ *
+ * UnrealEditor-Cmd MultiplayerShooter.uproject -run=NetTickBenchmark [-Clients=16,64,100] [-Duration=30] [-WarmUp=5]
+ *   [-Map=/Game/ThirdPerson/Maps/Lobby] [-Port=7777] [-IdleFraction=0.3] [-ServerStartup=20] [-Compare]
+ *
+ * -Compare runs each count a second time without the replication graph. The lobby doesn't start the match during a run.
+ * A simulated client is a whole game process without rendering: 100 of them take a big machine, or leave the server little CPU,
+ * so compare runs made on the same machine only.
+ */
+UCLASS()
+class UNetTickBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UNetTickBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};